@@ -0,0 +1,61 @@
+#include "bench.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Every allocation the library makes goes through here, such that regressions in the number of them show.
+static std::atomic<std::size_t> allocation_count(0);
+
+std::size_t get_allocation_count() {
+    return allocation_count.load();
+}
+
+void * operator new(std::size_t size) {
+
+    allocation_count++;
+
+    if (auto p = std::malloc(size ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void * operator new(std::size_t size, std::nothrow_t const &) noexcept {
+    allocation_count++;
+    return std::malloc(size ? size : 1);
+}
+
+void * operator new[](std::size_t size, std::nothrow_t const & tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void * p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void * p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void * p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void * p, std::nothrow_t const &) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void * p, std::nothrow_t const &) noexcept {
+    std::free(p);
+}
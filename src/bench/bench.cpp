@@ -0,0 +1,38 @@
+#include "bench.h"
+
+#include <cstdio>
+
+///////////////////////////////////////////////////////////////////////////////
+
+bench_timer::bench_timer()
+    : start(clock_type::now()) {
+}
+
+void bench_timer::restart() {
+    start = clock_type::now();
+}
+
+double bench_timer::elapsed_seconds() const {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// Names run to the dataset's description and then some, i.e. "records ... read, compute prefetched".
+static void print_line(std::string const & name, double amount, int precision, char const * unit,
+    double seconds, double allocations) {
+
+    printf("%-64s %12.*f %-4s %10.3f ms %12.1f %s/s", name.c_str(), precision, amount, unit,
+        seconds * 1000.0, seconds > 0 ? amount / seconds : 0.0, unit);
+
+    if (allocations >= 0)
+        printf(" %12.0f allocs", allocations);
+
+    printf("\n");
+}
+
+void report(std::string const & name, double nbytes, double seconds, double allocations) {
+    print_line(name, nbytes / (1024.0 * 1024.0), 1, "MB", seconds, allocations);
+}
+
+void report_count(std::string const & name, double count, char const * unit, double seconds, double allocations) {
+    print_line(name, count, 0, unit, seconds, allocations);
+}
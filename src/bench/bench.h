@@ -0,0 +1,68 @@
+#ifndef NETCDF_BENCH_H
+#define NETCDF_BENCH_H
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct bench_timer {
+
+    typedef std::chrono::high_resolution_clock clock_type;
+
+    bench_timer();
+
+    void restart();
+
+    double elapsed_seconds() const;
+
+private:
+
+    clock_type::time_point start;
+};
+
+/* Reports the throughput of a measurement, one line per measurement, in MB/s, along with the
+heap allocations of a single run, when counted. */
+void report(std::string const & name, double nbytes, double seconds, double allocations = -1);
+
+// Likewise, for work that is not measured in bytes, i.e. laying out so many vars, in units per second.
+void report_count(std::string const & name, double count, char const * unit, double seconds, double allocations = -1);
+
+// The number of times operator new has been called, by any thread, since the start.
+std::size_t get_allocation_count();
+
+// Runs the function once, returning the number of heap allocations it made.
+template<typename _Function>
+double count_allocations(_Function const & func) {
+    const auto before = get_allocation_count();
+    func();
+    return static_cast<double>(get_allocation_count() - before);
+}
+
+// Runs the function until it has taken at least min_seconds, returning the best of the runs.
+template<typename _Function>
+double measure(_Function const & func, double min_seconds = 0.5) {
+
+    double best = 0, total = 0;
+
+    for (auto runs = 0; total < min_seconds || runs < 3; runs++) {
+        bench_timer timer;
+        func();
+        const auto elapsed = timer.elapsed_seconds();
+        total += elapsed;
+        if (!runs || elapsed < best) best = elapsed;
+    }
+
+    return best;
+}
+
+void run_swap_bench(std::size_t nbytes);
+
+void run_header_bench(int nvars, int nattrs);
+
+void run_io_bench(std::size_t nbytes);
+
+#endif //NETCDF_BENCH_H
@@ -0,0 +1,148 @@
+#include "generator.h"
+#include "io/cdf_writer.h"
+
+#include <algorithm>
+#include <fstream>
+
+///////////////////////////////////////////////////////////////////////////////
+
+dataset_spec::dataset_spec()
+    : version(classic)
+    , nvars(1)
+    , nrecord_vars(0)
+    , nlat(1)
+    , nlon(1)
+    , numrecs(0)
+    , nattrs(0) {
+}
+
+dataset_spec dataset_spec::classic_grids(std::size_t nbytes) {
+
+    dataset_spec spec;
+
+    spec.version = classic;
+    spec.nvars = 16;
+    spec.nlat = 256;
+    spec.nlon = std::max<int64_t>(nbytes / (sizeof(float) * spec.nvars * spec.nlat), 1);
+    spec.nattrs = 8;
+
+    return spec;
+}
+
+dataset_spec dataset_spec::x64_grids(std::size_t nbytes) {
+
+    auto spec = classic_grids(nbytes / 2);
+
+    spec.version = x64;
+    spec.nrecord_vars = 2;
+    spec.numrecs = std::max<int64_t>(spec.nvars / spec.nrecord_vars, 1);
+
+    return spec;
+}
+
+dataset_spec dataset_spec::record_heavy(std::size_t nbytes) {
+
+    dataset_spec spec;
+
+    spec.version = classic;
+    spec.nvars = 2;
+    spec.nrecord_vars = 32;
+    spec.nlat = 8;
+    spec.nlon = 16;
+    spec.numrecs = std::max<int64_t>(nbytes / (sizeof(float) * spec.nrecord_vars * spec.nlat * spec.nlon), 1);
+    spec.nattrs = 4;
+
+    return spec;
+}
+
+dataset_spec dataset_spec::header_heavy(int nvars, int nattrs) {
+
+    dataset_spec spec;
+
+    spec.version = classic;
+    spec.nvars = nvars;
+    spec.nlon = 4;
+    spec.nattrs = nattrs;
+
+    return spec;
+}
+
+std::string dataset_spec::describe() const {
+    return std::to_string(nvars) + "+" + std::to_string(nrecord_vars) + " vars "
+        + std::to_string(nlat) + "x" + std::to_string(nlon)
+        + (nrecord_vars ? " x" + std::to_string(numrecs) + " recs" : "");
+}
+
+// Alternates text and numeric attrs, such that both are parsed.
+static void add_attrs(attributable & target, std::string const & prefix, int nattrs) {
+    target.reserve_attrs(static_cast<attr_vector::size_type>(nattrs));
+    for (auto j = 0; j < nattrs; j++) {
+        if (j % 2)
+            target.add_text_attr(prefix + "text_" + std::to_string(j), "units of measure");
+        else
+            target.add_attr<double_vector>(prefix + "values_" + std::to_string(j), { 0.5, 1.5 });
+    }
+}
+
+netcdf make_dataset(dataset_spec const & spec) {
+
+    netcdf cdf;
+
+    cdf.magic.version = spec.version;
+
+    cdf.reserve_dims(3);
+    cdf.reserve_vars(static_cast<var_vector::size_type>(spec.nvars + spec.nrecord_vars));
+
+    cdf.add_dim("time", 0);
+    cdf.add_dim("lat", spec.nlat);
+    cdf.add_dim("lon", spec.nlon);
+
+    // Adding dims may move them, so look them up once they are all in.
+    auto time_it = cdf.get_dim("time");
+    auto lat_it = cdf.get_dim("lat");
+    auto lon_it = cdf.get_dim("lon");
+
+    add_attrs(cdf, "global_", spec.nattrs);
+
+    const netcdf::dim_vector_iterator_vector grid_its = { lat_it, lon_it };
+    const netcdf::dim_vector_iterator_vector record_its = { time_it, lat_it, lon_it };
+
+    const auto nelems = static_cast<data_buffer::size_type>(spec.nlat * spec.nlon);
+
+    for (auto i = 0; i < spec.nvars + spec.nrecord_vars; i++) {
+
+        const auto is_record = i >= spec.nvars;
+
+        auto name = (is_record ? "rec_" : "var_") + std::to_string(i);
+
+        auto var_it = cdf.add_var(name, nc_float);
+
+        cdf.redim_var(var_it, is_record ? record_its : grid_its);
+
+        add_attrs(*var_it, "", spec.nattrs);
+
+        const auto n = nelems * (is_record ? static_cast<data_buffer::size_type>(spec.numrecs) : 1);
+
+        var_it->data.assign(nc_float, n);
+
+        auto p = var_it->data.data_as<float>();
+
+        for (data_buffer::size_type k = 0; k < n; k++)
+            p[k] = static_cast<float>(i) + static_cast<float>(k % 1000) * 0.001f;
+    }
+
+    cdf.numrecs = spec.nrecord_vars ? spec.numrecs : 0;
+
+    return cdf;
+}
+
+void write_dataset(dataset_spec const & spec, std::string const & path) {
+
+    auto cdf = make_dataset(spec);
+
+    std::ofstream ofs(path, std::ios::binary);
+
+    cdf_writer writer(&ofs, true);
+
+    writer << cdf;
+}
@@ -0,0 +1,52 @@
+#ifndef NETCDF_BENCH_GENERATOR_H
+#define NETCDF_BENCH_GENERATOR_H
+
+#pragma once
+
+#include "netcdf.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Describes a synthetic dataset: nvars non-record vars and nrecord_vars record vars, each a float
+grid of nlat by nlon, the latter numrecs records deep, with nattrs attrs apiece, globals as well. */
+struct dataset_spec {
+
+    cdf_version version;
+
+    int nvars;
+    int nrecord_vars;
+
+    int64_t nlat;
+    int64_t nlon;
+    int64_t numrecs;
+
+    int nattrs;
+
+    dataset_spec();
+
+    // Approximately nbytes of data, or the least there can be, in each of the shapes we care about.
+
+    // Mostly large non-record grids, as in a model's static fields, in the classic format.
+    static dataset_spec classic_grids(std::size_t nbytes);
+
+    // The same grids with a few records besides, in the 64-bit offset format.
+    static dataset_spec x64_grids(std::size_t nbytes);
+
+    // Many small record vars over many records, such that the data is thoroughly interleaved.
+    static dataset_spec record_heavy(std::size_t nbytes);
+
+    // Many vars with many attrs and next to no data, for header parsing.
+    static dataset_spec header_heavy(int nvars, int nattrs);
+
+    std::string describe() const;
+};
+
+netcdf make_dataset(dataset_spec const & spec);
+
+void write_dataset(dataset_spec const & spec, std::string const & path);
+
+#endif //NETCDF_BENCH_GENERATOR_H
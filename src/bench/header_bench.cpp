@@ -0,0 +1,51 @@
+#include "bench.h"
+#include "generator.h"
+#include "io/cdf_reader.h"
+
+#include <fstream>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+void run_header_bench(int nvars, int nattrs) {
+
+    const std::string path = "bench_header.nc";
+
+    write_dataset(dataset_spec::header_heavy(nvars, nattrs), path);
+
+    std::ifstream probe(path, std::ios::binary | std::ios::ate);
+    const auto nbytes = static_cast<double>(probe.tellg());
+
+    const auto shape = std::to_string(nvars) + " vars x " + std::to_string(nattrs) + " attrs";
+
+    // Building the same model through the add_* API, as a writer would.
+    auto build = [&]() {
+        make_dataset(dataset_spec::header_heavy(nvars, nattrs));
+    };
+
+    report("build model " + shape, nbytes, measure(build), count_allocations(build));
+
+    auto read = [&]() {
+        netcdf cdf;
+        std::ifstream ifs(path, std::ios::binary);
+        cdf_reader reader(&ifs, true);
+        reader.read_header(cdf);
+    };
+
+    report("read header " + shape, nbytes, measure(read), count_allocations(read));
+
+    // The same, into an arena reused from one file to the next, as a crawler of many files would.
+    memory_arena arena;
+
+    auto read_into_arena = [&]() {
+        arena.reset();
+        netcdf cdf;
+        std::ifstream ifs(path, std::ios::binary);
+        cdf_reader reader(&ifs, true);
+        reader.read_header(cdf, arena);
+    };
+
+    read_into_arena();
+
+    report("read header into arena " + shape, nbytes, measure(read_into_arena), count_allocations(read_into_arena));
+}
@@ -0,0 +1,166 @@
+#include "bench.h"
+#include "generator.h"
+#include "io/cdf_reader.h"
+#include "io/cdf_writer.h"
+#include "io/record_reader.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+static double get_file_size(std::string const & path) {
+    std::ifstream probe(path, std::ios::binary | std::ios::ate);
+    return static_cast<double>(probe.tellg());
+}
+
+static void run_dataset_bench(std::string const & kind, dataset_spec const & spec, thread_pool & pool) {
+
+    const auto path = "bench_" + kind + ".nc";
+    const auto prefix = kind + " " + spec.describe() + " ";
+
+    auto cdf = make_dataset(spec);
+
+    auto write = [&]() {
+        std::ofstream ofs(path, std::ios::binary);
+        cdf_writer writer(&ofs, true);
+        writer << cdf;
+    };
+
+    write();
+
+    const auto nbytes = get_file_size(path);
+
+    // The layout alone, i.e. the vsize and begin of every var, which touches no data, so by the var.
+    auto prepare = [&]() {
+        cdf_writer writer(nullptr, true);
+        writer.prepare_var_array(cdf);
+    };
+
+    report_count(prefix + "prepare", static_cast<double>(cdf.vars.size()), "vars", measure(prepare), count_allocations(prepare));
+
+    report(prefix + "write", nbytes, measure(write), count_allocations(write));
+
+    auto write_parallel = [&]() {
+        cdf_writer writer(std::make_shared<random_access_file>(path, random_access_file::create), true);
+        writer.write_cdf(cdf, pool);
+    };
+
+    report(prefix + "write parallel", nbytes, measure(write_parallel), count_allocations(write_parallel));
+
+    auto read = [&]() {
+        netcdf back;
+        std::ifstream ifs(path, std::ios::binary);
+        cdf_reader reader(&ifs, true);
+        reader >> back;
+    };
+
+    report(prefix + "read", nbytes, measure(read), count_allocations(read));
+
+    // The whole file already in memory, as from a cache: wrapped in a stream, and read in place.
+    std::string bytes;
+
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+
+    auto read_stream_memory = [&]() {
+        netcdf back;
+        std::istringstream iss(bytes);
+        cdf_reader reader(&iss, true);
+        reader >> back;
+    };
+
+    report(prefix + "read memory, stream", nbytes, measure(read_stream_memory), count_allocations(read_stream_memory));
+
+    auto read_memory = [&]() {
+        netcdf back;
+        cdf_reader reader(bytes.data(), bytes.size(), true);
+        reader >> back;
+        // Put in host byte order, the same as the stream read leaves it.
+        for (auto & aVar : back.vars)
+            aVar.get_data().materialize();
+    };
+
+    report(prefix + "read memory", nbytes, measure(read_memory), count_allocations(read_memory));
+
+    auto read_parallel = [&]() {
+        netcdf back;
+        cdf_reader reader(std::make_shared<random_access_file>(path), true);
+        reader.read_cdf(back, pool);
+    };
+
+    report(prefix + "read parallel", nbytes, measure(read_parallel), count_allocations(read_parallel));
+
+    // Stands in for the work done on each var as it comes in.
+    auto compute = [](var & aVar) {
+        auto const & theData = aVar.get_data();
+        auto p = theData.data_as<float>();
+        volatile float sum = 0;
+        for (data_buffer::size_type i = 0; i < theData.size(); i++)
+            sum = sum + p[i] * p[i];
+    };
+
+    auto read_then_compute = [&]() {
+        netcdf back;
+        cdf_reader reader(std::make_shared<random_access_file>(path), true);
+        reader.read_header(back);
+        for (auto & aVar : back.vars)
+            compute(aVar);
+    };
+
+    report(prefix + "read, compute", nbytes, measure(read_then_compute));
+
+    // The next var is read on a thread of its own while the one before is worked on.
+    thread_pool io(1);
+
+    auto prefetch_then_compute = [&]() {
+        netcdf back;
+        cdf_reader reader(std::make_shared<random_access_file>(path), true);
+        reader.read_header(back);
+        if (!back.vars.empty())
+            back.prefetch_var(back.vars.begin(), io);
+        for (auto it = back.vars.begin(); it != back.vars.end(); it++) {
+            if (it + 1 != back.vars.end())
+                back.prefetch_var(it + 1, io);
+            compute(*it);
+        }
+    };
+
+    report(prefix + "read, compute prefetched", nbytes, measure(prefetch_then_compute));
+
+    if (!spec.nrecord_vars) {
+        std::remove(path.c_str());
+        return;
+    }
+
+    // A record at a time, holding no more than the record at hand and the next.
+    auto walk_records = [&]() {
+        netcdf back;
+        cdf_reader reader(std::make_shared<random_access_file>(path), true);
+        reader.read_header(back);
+        for (auto & theRecord : record_reader(back, io))
+            for (record_reader::size_type i = 0; i < theRecord.get_vars().size(); i++)
+                theRecord.get_data(i);
+    };
+
+    const auto record_bytes = static_cast<double>(spec.numrecs * spec.nrecord_vars * spec.nlat * spec.nlon * sizeof(float));
+
+    report(prefix + "walk records", record_bytes, measure(walk_records));
+
+    std::remove(path.c_str());
+}
+
+void run_io_bench(std::size_t nbytes) {
+
+    thread_pool pool;
+
+    run_dataset_bench("classic", dataset_spec::classic_grids(nbytes), pool);
+    run_dataset_bench("x64", dataset_spec::x64_grids(nbytes), pool);
+    run_dataset_bench("records", dataset_spec::record_heavy(nbytes), pool);
+}
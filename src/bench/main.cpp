@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "generator.h"
+#include "io/network_byte_order.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char* argv[]) {
+
+    // Usage: bench generate <classic|x64|records> <path> [size in MB]
+    if (argc > 3 && !strcmp(argv[1], "generate")) {
+
+        const std::size_t nbytes = (argc > 4 ? static_cast<std::size_t>(atoi(argv[4])) : 64) * 1024 * 1024;
+
+        const auto kind = std::string(argv[2]);
+
+        dataset_spec spec;
+
+        if (kind == "classic")
+            spec = dataset_spec::classic_grids(nbytes);
+        else if (kind == "x64")
+            spec = dataset_spec::x64_grids(nbytes);
+        else if (kind == "records")
+            spec = dataset_spec::record_heavy(nbytes);
+        else {
+            fprintf(stderr, "unknown dataset: %s\n", kind.c_str());
+            return 1;
+        }
+
+        write_dataset(spec, argv[3]);
+
+        printf("%s: %s\n", argv[3], spec.describe().c_str());
+
+        return 0;
+    }
+
+    // Usage: bench [size in MB]
+    std::size_t size_mb = argc > 1 ? static_cast<std::size_t>(atoi(argv[1])) : 256;
+
+    printf("swap engine selected: %s\n\n", get_swap_engine_name(get_swap_engine()));
+
+    run_swap_bench(size_mb * 1024 * 1024);
+
+    printf("\n");
+
+    run_header_bench(1000, 20);
+
+    printf("\n");
+
+    run_io_bench(size_mb * 1024 * 1024);
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "bench.h"
+#include "io/network_byte_order.h"
+#include "parts/data_buffer.h"
+
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+
+void run_swap_bench(std::size_t nbytes) {
+
+    // A plain copy of the same size is the yardstick: bulk swapping should come close to it.
+    data_buffer src(nc_byte, nbytes), dest(nc_byte, nbytes);
+
+    for (std::size_t i = 0; i < nbytes; i++)
+        src.data_as<uint8_t>()[i] = static_cast<uint8_t>(i);
+
+    report("memcpy", static_cast<double>(nbytes),
+        measure([&]() { memcpy(dest.data(), src.data(), nbytes); }));
+
+    // The element by element reversal that the reader and writer used to do, for comparison.
+    report("swap per element x4", static_cast<double>(nbytes),
+        measure([&]() {
+        auto p = dest.data_as<uint8_t>();
+        for (auto end = p + nbytes; p != end; p += sizeof(uint32_t))
+            swap_endian(*reinterpret_cast<uint32_t *>(p));
+    }));
+
+    const auto selected = get_swap_engine();
+
+    const swap_engine engines[] = { swap_portable, swap_ssse3, swap_avx2 };
+    const std::size_t widths[] = { 2, 4, 8 };
+
+    for (auto engine : engines) {
+
+        if (!set_swap_engine(engine)) continue;
+
+        for (auto width : widths) {
+
+            const auto nelems = nbytes / width;
+            const auto prefix = std::string("swap ") + get_swap_engine_name(engine) + " x" + std::to_string(width);
+
+            report(prefix + " copy", static_cast<double>(nelems * width),
+                measure([&]() { swap_endian_array(dest.data(), src.data(), width, nelems); }));
+
+            report(prefix + " in place", static_cast<double>(nelems * width),
+                measure([&]() { swap_endian_array(dest.data(), width, nelems); }));
+        }
+    }
+
+    set_swap_engine(selected);
+}
@@ -0,0 +1,258 @@
+#include "block_reader.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+///////////////////////////////////////////////////////////////////////////////
+
+block_reader::block_reader(std::istream * pIS, size_type block_size)
+    : pIS(pIS)
+    , pFile(nullptr)
+    , block(block_size)
+    , pblock(block.data())
+    , block_pos(static_cast<pos_type>(pIS->tellg()))
+    , cur(0)
+    , end(0) {
+
+    // Not every stream knows where it is; count from wherever that is.
+    if (block_pos < 0) block_pos = 0;
+}
+
+block_reader::block_reader(char const * p, size_type n)
+    : pIS(nullptr)
+    , pFile(nullptr)
+    , block()
+    , pblock(p)
+    , block_pos(0)
+    , cur(0)
+    , end(n) {
+}
+
+block_reader::block_reader(random_access_file const * pFile, size_type block_size)
+    : pIS(nullptr)
+    , pFile(pFile)
+    , block(block_size)
+    , pblock(block.data())
+    , block_pos(0)
+    , cur(0)
+    , end(0) {
+}
+
+block_reader::size_type block_reader::get_available() const {
+    return end - cur;
+}
+
+block_reader::size_type block_reader::read_source(void * dest, size_type n) {
+
+    if (pFile)
+        return pFile->read_at(block_pos, dest, n);
+
+    pIS->read(static_cast<char *>(dest), n);
+    return static_cast<size_type>(pIS->gcount());
+}
+
+void block_reader::refill() {
+    if (!try_refill())
+        throw std::runtime_error("unexpected end of file");
+}
+
+bool block_reader::try_refill() {
+
+    // There is nothing beyond the memory being read.
+    if (!pIS && !pFile)
+        return false;
+
+    // The source is positioned at the end of the block; the next block picks up from there.
+    block_pos += end;
+    cur = end = 0;
+
+    end = read_source(block.data(), block.size());
+
+    return end > 0;
+}
+
+void block_reader::read_through(void * dest, size_type n) {
+
+    auto p = static_cast<char *>(dest);
+
+    const auto large = n >= block.size() / 2;
+
+    // Whatever is left in the block comes first.
+    const auto available = get_available();
+    memcpy(p, pblock + cur, available);
+    cur += available;
+    p += available;
+    n -= available;
+
+    // The rest of a large read goes straight out however little of it there is, leaving the block empty.
+    if ((pIS || pFile) && large) {
+
+        // Large reads go straight to their destination rather than through the block.
+        block_pos += end;
+        cur = end = 0;
+
+        const auto count = read_source(p, n);
+        block_pos += count;
+
+        if (count != n)
+            throw std::runtime_error("unexpected end of file");
+
+        return;
+    }
+
+    while (n) {
+        refill();
+        const auto count = std::min(n, get_available());
+        memcpy(p, pblock + cur, count);
+        cur += count;
+        p += count;
+        n -= count;
+    }
+}
+
+void block_reader::skip(size_type n) {
+
+    if (!pIS || n <= get_available()) {
+        seek(tell() + static_cast<pos_type>(n));
+        return;
+    }
+
+    n -= get_available();
+    cur = end;
+
+    while (n) {
+        refill();
+        const auto count = std::min(n, get_available());
+        cur += count;
+        n -= count;
+    }
+}
+
+block_reader::size_type block_reader::read_upto(void * dest, size_type n) {
+
+    auto p = static_cast<char *>(dest);
+    size_type result = 0;
+
+    while (result < n) {
+
+        if (!get_available() && !try_refill())
+            break;
+
+        const auto count = std::min(n - result, get_available());
+        memcpy(p + result, pblock + cur, count);
+        cur += count;
+        result += count;
+    }
+
+    return result;
+}
+
+void block_reader::seek(pos_type pos) {
+
+    // Seeking within the block is just a matter of moving the cursor.
+    if (pos >= block_pos && pos <= block_pos + static_cast<pos_type>(end)) {
+        cur = static_cast<size_type>(pos - block_pos);
+        return;
+    }
+
+    // Reading by position, there is nothing to seek; the next refill starts from here.
+    if (pFile) {
+        block_pos = pos;
+        cur = end = 0;
+        return;
+    }
+
+    if (!pIS)
+        throw std::runtime_error("unable to seek");
+
+    pIS->clear();
+    pIS->seekg(pos, std::ios::beg);
+
+    if (pIS->fail())
+        throw std::runtime_error("unable to seek");
+
+    block_pos = pos;
+    cur = end = 0;
+}
+
+void block_reader::read_at(pos_type pos, void * dest, size_type n) {
+
+    if (pos >= block_pos && pos + static_cast<pos_type>(n) <= block_pos + static_cast<pos_type>(end)) {
+        cur = static_cast<size_type>(pos - block_pos);
+        read(dest, n);
+        return;
+    }
+
+    if (!pIS && !pFile)
+        throw std::runtime_error("unexpected end of file");
+
+    if (pIS) {
+
+        pIS->clear();
+        pIS->seekg(pos, std::ios::beg);
+
+        if (pIS->fail())
+            throw std::runtime_error("unable to seek");
+    }
+
+    block_pos = pos;
+
+    const auto count = read_source(dest, n);
+
+    block_pos = pos + static_cast<pos_type>(count);
+    cur = end = 0;
+
+    if (count != n)
+        throw std::runtime_error("unexpected end of file");
+}
+
+void block_reader::read_strided(pos_type pos, pos_type stride, size_type n, size_type count, void * dest) {
+
+    auto p = static_cast<char *>(dest);
+
+    if (pFile) {
+        pFile->read_strided(pos, stride, n, count, dest);
+        return;
+    }
+
+    for (size_type i = 0; i < count; i++, pos += stride, p += n)
+        read_at(pos, p, n);
+}
+
+block_reader::pos_type block_reader::tell() const {
+    return block_pos + static_cast<pos_type>(cur);
+}
+
+block_reader::pos_type block_reader::get_source_size() const {
+
+    if (pFile)
+        return pFile->size();
+
+    if (!pIS)
+        return static_cast<pos_type>(end);
+
+    // Look to the end of the stream, then put it back where it was; a short read may have failed it.
+    pIS->clear();
+
+    const auto pos = pIS->tellg();
+
+    if (pos == std::istream::pos_type(-1))
+        return -1;
+
+    pIS->seekg(0, std::ios::end);
+
+    const auto result = static_cast<pos_type>(pIS->tellg());
+
+    pIS->clear();
+    pIS->seekg(pos);
+
+    return result;
+}
+
+char const * block_reader::map(pos_type pos, size_type n) const {
+
+    if (pIS || pFile || pos < 0 || pos + static_cast<pos_type>(n) > static_cast<pos_type>(end))
+        return nullptr;
+
+    return pblock + pos;
+}
@@ -0,0 +1,105 @@
+#ifndef NETCDF_BLOCK_READER_H
+#define NETCDF_BLOCK_READER_H
+
+#pragma once
+
+#include "random_access_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Sits between the reader and its stream, reading the stream a large block at a time and
+handing out bounds-checked reads from a cursor into the block. Small reads, i.e. header fields,
+are an inline memcpy; reads larger than the block go straight from the stream to their
+destination, so a variable is read in as few stream calls as its size allows. When reading
+from memory, i.e. a file mapping, the whole of the memory is the block, and is never refilled.
+When reading from a file handle, the block is refilled by position, so there is no seeking. */
+struct block_reader {
+
+    typedef std::size_t size_type;
+    typedef int64_t pos_type;
+
+    static const size_type default_block_size = 1024 * 1024;
+
+    block_reader(std::istream * pIS, size_type block_size = default_block_size);
+    block_reader(char const * p, size_type n);
+    block_reader(random_access_file const * pFile, size_type block_size = default_block_size);
+
+    template<typename _Ty>
+    _Ty read() {
+        _Ty x;
+        read(&x, sizeof(x));
+        return x;
+    }
+
+    void read(void * dest, size_type n) {
+
+        if (n <= get_available()) {
+            memcpy(dest, pblock + cur, n);
+            cur += n;
+            return;
+        }
+
+        read_through(dest, n);
+    }
+
+    /* Moves on n bytes. Streams are read past rather than sought, such that the reader may go
+on through a pipe, i.e. stdin, which has no position to seek to. */
+    void skip(size_type n);
+
+    // Reads up to n bytes, returning how many were read; fewer only at the end of the input.
+    size_type read_upto(void * dest, size_type n);
+
+    void seek(pos_type pos);
+
+    pos_type tell() const;
+
+    // Returns the size of the whole input, or -1 when it cannot tell, i.e. a pipe.
+    pos_type get_source_size() const;
+
+    /* Reads the n bytes at pos, leaving the reader positioned just past them. Bytes outside the
+    block are read from the stream as exactly that, without refilling the block, such that many
+    small scattered reads, i.e. a hyperslab, touch no more of the stream than they need. */
+    void read_at(pos_type pos, void * dest, size_type n);
+
+    // Reads count runs of n bytes, stride bytes apart starting at pos, back to back into dest.
+    void read_strided(pos_type pos, pos_type stride, size_type n, size_type count, void * dest);
+
+    // Returns the n bytes at pos in place, when reading from memory, otherwise nullptr.
+    char const * map(pos_type pos, size_type n) const;
+
+private:
+
+    size_type get_available() const;
+
+    void read_through(void * dest, size_type n);
+
+    void refill();
+
+    // As refill, but returns whether there was anything left to fill the block with.
+    bool try_refill();
+
+    // Fills the block, or reads large reads, from whichever of the stream or the file there is.
+    size_type read_source(void * dest, size_type n);
+
+    std::istream * pIS;
+
+    random_access_file const * pFile;
+
+    std::vector<char> block;
+
+    // Either the block, or the memory being read.
+    char const * pblock;
+
+    // Stream position of the first byte in the block.
+    pos_type block_pos;
+
+    size_type cur;
+    size_type end;
+};
+
+#endif //NETCDF_BLOCK_READER_H
@@ -0,0 +1,150 @@
+#include "cdf_appender.h"
+#include "cdf_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+///////////////////////////////////////////////////////////////////////////////
+
+cdf_appender::cdf_appender(std::shared_ptr<random_access_file> const & file, bool reverse_byte_order)
+    : cdf_binary_base(reverse_byte_order)
+    , file(file)
+    , cdf()
+    , record_vars()
+    , records_begin(0)
+    , recsize(0)
+    , record() {
+
+    cdf_reader(file, reverse_byte_order).read_header(cdf);
+
+    // A file still being streamed does not yet know where its records end.
+    if (cdf.numrecs == netcdf::streaming)
+        throw std::runtime_error("numrecs is indeterminate");
+
+    const auto useClassic = cdf.magic.is_classic();
+
+    for (auto & aVar : cdf.vars)
+        if (aVar.is_record(cdf.dims))
+            record_vars.push_back(&aVar);
+
+    if (record_vars.empty())
+        throw std::runtime_error("there are no record vars to append to");
+
+    auto get_begin = [&](var const * pVar) {
+        return useClassic ? static_cast<int64_t>(pVar->offset.begin) : pVar->offset.begin64;
+    };
+
+    // Sort the record vars by where they fall within the record.
+    std::sort(record_vars.begin(), record_vars.end(),
+        [&](var const * a, var const * b) { return get_begin(a) < get_begin(b); });
+
+    records_begin = get_begin(record_vars.front());
+    recsize = cdf.get_recsize();
+}
+
+cdf_appender::~cdf_appender() {
+}
+
+netcdf const & cdf_appender::get_cdf() const {
+    return cdf;
+}
+
+int64_t cdf_appender::append_records(var_vector const & vars) {
+
+    // Match each record var of the file with the var, if any, from which its records come.
+    std::vector<var const *> sources(record_vars.size(), nullptr);
+
+    int64_t count = 0;
+
+    for (auto & aVar : vars) {
+
+        auto it = std::find_if(record_vars.begin(), record_vars.end(),
+            [&](var const * x) { return x->name == aVar.name; });
+
+        if (it == record_vars.end())
+            throw std::invalid_argument("not a record var of the file");
+
+        if ((*it)->get_type() != aVar.get_type())
+            throw std::invalid_argument("record var type mismatch");
+
+        // The vars are the caller's, and const, so they cannot be loaded here; not loaded, they would append nothing.
+        if (!aVar.is_loaded())
+            throw std::invalid_argument("record var not loaded");
+
+        const auto record_nelems = (*it)->get_nelems(cdf.dims);
+
+        // A record of no elements, i.e. along a fixed dim of no length, holds no records whatever the data.
+        const auto nrecords = record_nelems
+            ? static_cast<int64_t>((aVar.data.size() + record_nelems - 1) / record_nelems) : 0;
+
+        count = std::max(count, nrecords);
+
+        sources[it - record_vars.begin()] = &aVar;
+    }
+
+    for (int64_t r = 0; r < count; r++)
+        write_record(r, sources);
+
+    // Only once the records are in place are they counted.
+    cdf.numrecs += count;
+
+    write_numrecs();
+
+    return count;
+}
+
+void cdf_appender::write_record(int64_t r, std::vector<var const *> const & sources) {
+
+    record.assign(static_cast<std::vector<char>::size_type>(recsize), 0);
+
+    const auto useClassic = cdf.magic.is_classic();
+
+    for (std::vector<var const *>::size_type i = 0; i < record_vars.size(); i++) {
+
+        auto pSource = sources[i];
+
+        if (!pSource) continue;
+
+        auto pVar = record_vars[i];
+
+        const int64_t begin = useClassic ? pVar->offset.begin : pVar->offset.begin64;
+
+        const auto width = data_buffer::get_element_size(pVar->get_type());
+        const auto record_nelems = pVar->get_nelems(cdf.dims);
+        const auto first = record_nelems * r;
+
+        auto const & theData = pSource->data;
+
+        if (theData.size() <= first) continue;
+
+        const auto nelems = std::min(record_nelems, theData.size() - first);
+
+        auto src = static_cast<char const *>(theData.bytes()) + first * width;
+        auto dest = record.data() + (begin - records_begin);
+
+        // A view still in file byte order is reversed only when the file is not.
+        if (reverse_byte_order == theData.is_host_order() && width > 1)
+            swap_endian_array(dest, src, width, nelems);
+        else
+            memcpy(dest, src, nelems * width);
+    }
+
+    file->write_at(records_begin + (cdf.numrecs + r) * recsize, record.data(), record.size());
+}
+
+void cdf_appender::write_numrecs() {
+
+    // numrecs follows the magic, i.e. 'C' 'D' 'F' VERSION_BYTE.
+    const int64_t numrecs_pos = 4;
+
+    // It is INT64 for CDF-5, otherwise INT.
+    if (cdf.magic.has_x64_sizes()) {
+        auto numrecs = get_reversed_byte_order(cdf.numrecs);
+        file->write_at(numrecs_pos, &numrecs, sizeof(numrecs));
+    }
+    else {
+        auto numrecs = get_reversed_byte_order(static_cast<int32_t>(cdf.numrecs));
+        file->write_at(numrecs_pos, &numrecs, sizeof(numrecs));
+    }
+}
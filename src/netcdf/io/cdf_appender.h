@@ -0,0 +1,56 @@
+#ifndef NETCDF_CDF_APPENDER_H
+#define NETCDF_CDF_APPENDER_H
+
+#pragma once
+
+#include "../netcdf.h"
+#include "cdf_binary_base.h"
+#include "random_access_file.h"
+
+#include <memory>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Appends records to an existing classic, 64-bit offset or 64-bit data file, in place. The
+header is read once, on open; thereafter each append writes just the new records past the last
+one, and then patches numrecs in the header, such that the cost of an append is that of the
+records appended, not of the file. */
+struct cdf_appender : public cdf_binary_base {
+
+    cdf_appender(std::shared_ptr<random_access_file> const & file, bool reverse_byte_order = true);
+
+    virtual ~cdf_appender();
+
+    // The file as it stands; its vars load lazily, as of when it was opened.
+    netcdf const & get_cdf() const;
+
+    /* Appends the records held by the vars, each of which is matched by name with a record var of
+    the file, and must be of the same type. Each var holds one or more whole records; as many
+    records are appended as the longest of them holds, and records that a var does not reach, as
+    well as any record var not given at all, are written as zeros. The vars must be loaded. Returns
+    the number of records appended. */
+    int64_t append_records(var_vector const & vars);
+
+private:
+
+    // Lays out the record in file byte order, padding included, and writes it in one call.
+    void write_record(int64_t r, std::vector<var const *> const & sources);
+
+    void write_numrecs();
+
+    std::shared_ptr<random_access_file> file;
+
+    netcdf cdf;
+
+    // The record vars of the file, in the order they appear within a record.
+    std::vector<var const *> record_vars;
+
+    // Where the first record begins, and the distance between records.
+    int64_t records_begin;
+    int64_t recsize;
+
+    std::vector<char> record;
+};
+
+#endif //NETCDF_CDF_APPENDER_H
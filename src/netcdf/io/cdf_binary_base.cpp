@@ -1,10 +1,18 @@
-#include "cdf_binary_base.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-cdf_binary_base::cdf_binary_base(bool reverse_byte_order)
-    : reverse_byte_order(reverse_byte_order) {
-}
-
-cdf_binary_base::~cdf_binary_base() {
-}
+#include "cdf_binary_base.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+cdf_binary_base::cdf_binary_base(bool reverse_byte_order)
+    : reverse_byte_order(reverse_byte_order) {
+}
+
+cdf_binary_base::~cdf_binary_base() {
+}
+
+void cdf_binary_base::reverse_byte_order_of(data_buffer & theData) {
+
+    if (!reverse_byte_order) return;
+
+    // Every numeric type is covered here, all in one go; single byte elements are left as they are.
+    swap_endian_array(theData.data(), data_buffer::get_element_size(theData.get_type()), theData.size());
+}
@@ -1,35 +1,47 @@
-#ifndef NETCDF_CDF_BINARY_BASE_H
-#define NETCDF_CDF_BINARY_BASE_H
-
-#pragma once
-
-#include "network_byte_order.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct cdf_binary_base {
-
-    virtual ~cdf_binary_base();
-
-protected:
-
-    bool reverse_byte_order;
-
-protected:
-
-    cdf_binary_base(bool reverse_byte_order = true);
-
-private:
-
-    cdf_binary_base(cdf_binary_base const &) {}
-
-protected:
-
-    template<typename _Ty>
-    _Ty get_reversed_byte_order(_Ty const & x) {
-        _Ty local = x;
-        return reverse_byte_order ? swap_endian(local) : local;
-    }
-};
-
-#endif //NETCDF_CDF_BINARY_BASE_H
+#ifndef NETCDF_CDF_BINARY_BASE_H
+#define NETCDF_CDF_BINARY_BASE_H
+
+#pragma once
+
+#include "network_byte_order.h"
+#include "../parts/data_buffer.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct cdf_binary_base {
+
+    virtual ~cdf_binary_base();
+
+protected:
+
+    bool reverse_byte_order;
+
+protected:
+
+    cdf_binary_base(bool reverse_byte_order = true);
+
+private:
+
+    cdf_binary_base(cdf_binary_base const &) {}
+
+protected:
+
+    template<typename _Ty>
+    _Ty get_reversed_byte_order(_Ty const & x) {
+        _Ty local = x;
+        return reverse_byte_order ? swap_endian(local) : local;
+    }
+
+    /* Reverses the byte order of the value in place, when so required. This is the safe way to
+    handle floating point values, which ought not pass through a register while reversed. */
+    template<typename _Ty>
+    void reverse_byte_order_of(_Ty & x) {
+        if (reverse_byte_order)
+            swap_endian_array(&x, sizeof(x), 1);
+    }
+
+    // Reverses the byte order of each element in the block, in place, when so required.
+    void reverse_byte_order_of(data_buffer & theData);
+};
+
+#endif //NETCDF_CDF_BINARY_BASE_H
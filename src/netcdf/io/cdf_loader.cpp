@@ -0,0 +1,304 @@
+#include "cdf_loader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+///////////////////////////////////////////////////////////////////////////////
+
+cdf_loader::cdf_loader(std::istream * pIS, bool reverse_byte_order, netcdf const & theCdf)
+    : data_loader()
+    , cdf_binary_base(reverse_byte_order)
+    , input(pIS)
+    , keeper()
+    , pFile(nullptr)
+    , dims(theCdf.dims)
+    , numrecs(theCdf.numrecs)
+    , recsize(theCdf.get_recsize())
+    , useClassic(theCdf.magic.is_classic())
+    , mutex() {
+}
+
+cdf_loader::cdf_loader(std::shared_ptr<mapped_file> const & file, bool reverse_byte_order, netcdf const & theCdf)
+    : data_loader()
+    , cdf_binary_base(reverse_byte_order)
+    , input(file->data(), file->size())
+    , keeper(file)
+    , pFile(nullptr)
+    , dims(theCdf.dims)
+    , numrecs(theCdf.numrecs)
+    , recsize(theCdf.get_recsize())
+    , useClassic(theCdf.magic.is_classic())
+    , mutex() {
+}
+
+cdf_loader::cdf_loader(std::shared_ptr<random_access_file> const & handle, bool reverse_byte_order, netcdf const & theCdf)
+    : data_loader()
+    , cdf_binary_base(reverse_byte_order)
+    , input(handle.get())
+    , keeper(handle)
+    , pFile(handle.get())
+    , dims(theCdf.dims)
+    , numrecs(theCdf.numrecs)
+    , recsize(theCdf.get_recsize())
+    , useClassic(theCdf.magic.is_classic())
+    , mutex() {
+}
+
+cdf_loader::cdf_loader(char const * p, std::size_t n, bool reverse_byte_order, netcdf const & theCdf)
+    : data_loader()
+    , cdf_binary_base(reverse_byte_order)
+    , input(p, n)
+    , keeper()
+    , pFile(nullptr)
+    , dims(theCdf.dims)
+    , numrecs(theCdf.numrecs)
+    , recsize(theCdf.get_recsize())
+    , useClassic(theCdf.magic.is_classic())
+    , mutex() {
+}
+
+cdf_loader::~cdf_loader() {
+}
+
+void cdf_loader::load(var const & theVar, data_buffer & theData) {
+
+    const block_reader::pos_type pos = useClassic ? theVar.offset.begin : theVar.offset.begin64;
+
+    const auto type = theVar.get_type();
+
+    const auto width = data_buffer::get_element_size(type);
+
+    // The vsize includes padding, so go by the dims for the element count, i.e. of one record.
+    const auto record_nelems = theVar.get_nelems(dims);
+
+    const auto is_record = theVar.is_record(dims);
+
+    const auto nrecords = is_record ? static_cast<data_buffer::size_type>(numrecs) : 1;
+
+    const auto nelems = record_nelems * nrecords;
+
+    const auto record_size = record_nelems * width;
+
+    // There is nothing to read of a record var without records, which may begin past the end of the file.
+    if (!nelems) {
+        theData.assign(type, 0);
+        return;
+    }
+
+    // A lone record var has its records back to back, the same as a non-record var.
+    const auto contiguous = !is_record || nrecords < 2 || recsize == static_cast<int64_t>(record_size);
+
+    if (pFile) {
+
+        theData.assign_uninitialized(type, nelems);
+
+        if (!contiguous)
+            pFile->read_strided(pos, recsize, record_size, nrecords, theData.data());
+        else if (pFile->read_at(pos, theData.data(), theData.size_in_bytes()) != theData.size_in_bytes())
+            throw std::runtime_error("unexpected end of file");
+
+        reverse_byte_order_of(theData);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (contiguous) {
+
+        // Data that is already in memory, i.e. mapped, is viewed in place rather than read.
+        auto p = input.map(pos, nelems * width);
+
+        if (p) {
+            theData.assign_view(type, nelems, p, keeper, reverse_byte_order);
+            return;
+        }
+
+        input.seek(pos);
+
+        // Allocate the block once and read the data straight into it, then put it in host byte order.
+        theData.assign_uninitialized(type, nelems);
+
+        input.read(theData.data(), theData.size_in_bytes());
+    }
+    else {
+
+        // Otherwise the records are interleaved with those of the other record vars, recsize apart.
+        theData.assign_uninitialized(type, nelems);
+
+        input.read_strided(pos, recsize, record_size, nrecords, theData.data());
+    }
+
+    reverse_byte_order_of(theData);
+}
+
+void cdf_loader::load(std::vector<var *> const & vars, thread_pool & pool) {
+
+    if (!pFile) {
+        data_loader::load(vars, pool);
+        return;
+    }
+
+    typedef data_buffer::size_type size_type;
+
+    // Large enough to amortize the call, small enough to spread a single large var across the pool.
+    const size_type chunk_size = 4 * 1024 * 1024;
+
+    // Where each record of an interleaved record var goes, once its run of records has been read.
+    struct record_target {
+        char * dest;
+        block_reader::pos_type pos;
+        size_type record_size;
+        size_type width;
+        bool reversed;
+    };
+
+    std::vector<record_target> targets;
+
+    // The loads are waited for apart from anything else on the pool, i.e. prefetches.
+    thread_pool::batch tasks(pool);
+
+    for (auto pVar : vars) {
+
+        const block_reader::pos_type pos = useClassic ? pVar->offset.begin : pVar->offset.begin64;
+
+        auto & theData = pVar->data;
+
+        const auto type = pVar->get_type();
+        const auto width = data_buffer::get_element_size(type);
+        const auto record_nelems = pVar->get_nelems(dims);
+        const auto nrecords = pVar->is_record(dims) ? static_cast<size_type>(numrecs) : 1;
+        const auto record_size = record_nelems * width;
+        const auto reversed = reverse_byte_order && width > 1;
+
+        theData.assign_uninitialized(type, record_nelems * nrecords);
+
+        if (theData.empty()) continue;
+
+        auto dest = static_cast<char *>(theData.data());
+
+        if (nrecords < 2 || recsize == static_cast<int64_t>(record_size)) {
+
+            // Contiguous data is split into chunks of whole elements.
+            const auto total = theData.size_in_bytes();
+            const auto step = std::max<size_type>(chunk_size / width, 1) * width;
+
+            for (size_type first = 0; first < total; first += step) {
+
+                const auto n = std::min(step, total - first);
+
+                tasks.submit([=]() {
+
+                    if (pFile->read_at(pos + first, dest + first, n) != n)
+                        throw std::runtime_error("unexpected end of file");
+
+                    if (reversed)
+                        swap_endian_array(dest + first, width, n / width);
+                });
+            }
+        }
+        else {
+            targets.push_back({ dest, pos, record_size, width, reversed });
+        }
+    }
+
+    const auto stride = static_cast<size_type>(recsize);
+    const auto nrecords = static_cast<size_type>(numrecs);
+
+    // Much the same as read_strided, i.e. narrow gaps are read over, wide ones skipped.
+    const size_type max_gap = 64 * 1024;
+
+    auto lo = targets.empty() ? 0 : targets.front().pos;
+    auto hi = lo;
+
+    // What a record costs to read var by var, against reading the vars of it together.
+    size_type separately = 0;
+
+    for (auto & target : targets) {
+        lo = std::min(lo, target.pos);
+        hi = std::max(hi, target.pos + static_cast<block_reader::pos_type>(target.record_size));
+        separately += stride - target.record_size > max_gap ? target.record_size : stride;
+    }
+
+    const auto span = static_cast<size_type>(hi - lo);
+
+    if (!targets.empty() && span <= separately) {
+
+        /* The interleaved record vars are read together, runs of whole records at a time, each run
+        read once, from the first of the vars to the end of the last within a record, and then
+        scattered to every var, the same as compose_records does the other way round. */
+        // Small enough for a run to still be in cache as it is scattered.
+        const size_type run_size = 1024 * 1024;
+        const auto step = std::max<size_type>(run_size / stride, 1);
+
+        for (size_type r = 0; r < nrecords; r += step) {
+
+            const auto count = std::min(step, nrecords - r);
+
+            tasks.submit([=, &targets]() {
+
+                std::vector<char> buffer((count - 1) * stride + span);
+
+                if (pFile->read_at(lo + static_cast<block_reader::pos_type>(r * stride), buffer.data(), buffer.size()) != buffer.size())
+                    throw std::runtime_error("unexpected end of file");
+
+                for (auto & target : targets) {
+
+                    auto p = target.dest + r * target.record_size;
+                    auto src = buffer.data() + (target.pos - lo);
+
+                    for (size_type i = 0; i < count; i++)
+                        std::memcpy(p + i * target.record_size, src + i * stride, target.record_size);
+
+                    if (target.reversed)
+                        swap_endian_array(p, target.width, count * target.record_size / target.width);
+                }
+            });
+        }
+    }
+    else {
+
+        // A few narrow vars among wide ones are read on their own, runs of whole records at a time.
+        for (auto & target : targets) {
+
+            const auto step = std::max<size_type>(chunk_size / target.record_size, 1);
+
+            for (size_type r = 0; r < nrecords; r += step) {
+
+                const auto count = std::min(step, nrecords - r);
+
+                tasks.submit([=]() {
+
+                    auto p = target.dest + r * target.record_size;
+
+                    pFile->read_strided(target.pos + static_cast<block_reader::pos_type>(r * stride), recsize, target.record_size, count, p);
+
+                    if (target.reversed)
+                        swap_endian_array(p, target.width, count * target.record_size / target.width);
+                });
+            }
+        }
+    }
+
+    // The record runs refer to the targets, so wait before they go out of scope.
+    tasks.wait();
+}
+
+void cdf_loader::read_slab(var const & theVar, slab const & theSlab, slab::index_vector const & shape, data_buffer & theData) {
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const block_reader::pos_type begin = useClassic ? theVar.offset.begin : theVar.offset.begin64;
+
+    const auto width = static_cast<block_reader::pos_type>(data_buffer::get_element_size(theVar.get_type()));
+
+    auto dest = static_cast<char *>(theData.data());
+
+    theSlab.for_each_run(shape, theVar.is_record(dims),
+        [&](int64_t record, int64_t offset, int64_t slab_offset, int64_t nelems) {
+        input.read_at(begin + record * recsize + offset * width,
+            dest + slab_offset * width, static_cast<block_reader::size_type>(nelems * width));
+    });
+
+    reverse_byte_order_of(theData);
+}
@@ -0,0 +1,71 @@
+#ifndef NETCDF_CDF_LOADER_H
+#define NETCDF_CDF_LOADER_H
+
+#pragma once
+
+#include "../netcdf.h"
+#include "cdf_binary_base.h"
+#include "block_reader.h"
+#include "mapped_file.h"
+#include "random_access_file.h"
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <mutex>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Loads variable data on behalf of the model, from the same input the header was read from.
+The input must outlive any var that may yet load from it; a mapped file is kept alive by the
+loader itself, as is a file handle. Loads are serialized, since the input has but one position at a time. */
+struct cdf_loader : public data_loader, public cdf_binary_base {
+
+    cdf_loader(std::istream * pIS, bool reverse_byte_order, netcdf const & cdf);
+
+    cdf_loader(std::shared_ptr<mapped_file> const & file, bool reverse_byte_order, netcdf const & cdf);
+
+    cdf_loader(std::shared_ptr<random_access_file> const & handle, bool reverse_byte_order, netcdf const & cdf);
+
+    // Loads from memory owned by the caller, which is on the caller to keep alive.
+    cdf_loader(char const * p, std::size_t n, bool reverse_byte_order, netcdf const & cdf);
+
+    virtual ~cdf_loader();
+
+    using data_loader::load;
+
+    /* Reading a file by position, the load takes no lock, such that any number of loads, i.e.
+    prefetches, may run at once. Otherwise loads are taken one at a time. */
+    virtual void load(var const & aVar, data_buffer & theData);
+
+    /* Loads the vars in chunks, across the pool, when reading a file by position; each chunk is
+    read and put in host byte order by the thread it falls to. Interleaved record vars are read
+    together, a run of whole records at a time, each run read once for all of them, unless they
+    are a few narrow ones among wide ones. Otherwise one var at a time. */
+    virtual void load(std::vector<var *> const & vars, thread_pool & pool);
+
+    virtual void read_slab(var const & aVar, slab const & aSlab, slab::index_vector const & shape, data_buffer & theData);
+
+private:
+
+    block_reader input;
+
+    // Keeps the memory being read alive for as long as any variable data views it.
+    std::shared_ptr<void const> keeper;
+
+    // The file, when reading one by position, which any number of threads may read at once.
+    random_access_file const * pFile;
+
+    // The dims at the time the header was read, which is what describes the data on disk.
+    dim_vector dims;
+
+    // Likewise the number of records, and the distance between them.
+    int64_t numrecs;
+    int64_t recsize;
+
+    bool useClassic;
+
+    std::mutex mutex;
+};
+
+#endif //NETCDF_CDF_LOADER_H
@@ -1,312 +1,579 @@
-#include "cdf_reader.h"
-
-#include <cassert>
-#include <set>
-
-template<typename _Ty>
-_Ty read(std::istream & is) {
-    _Ty x;
-    is.read(reinterpret_cast<char*>(&x), sizeof(x));
-    return x;
-}
-
-cdf_version to_cdf_version(uint8_t value) {
-    switch (value) {
-    case classic: return classic;
-    case x64: return x64;
-    }
-    throw std::exception("unsupported cdf version");
-}
-
-cdf_reader::cdf_reader(std::istream * pIS, bool reverse_byte_order)
-    : cdf_binary_base(reverse_byte_order)
-    , pIS(pIS) {
-}
-
-void cdf_reader::read_magic(magic & magic) {
-
-    const auto key_size = sizeof(magic::key_type);
-
-    char tmp[key_size];
-
-    pIS->read(tmp, key_size);
-
-    for (auto i = 0; i < key_size; i++)
-        if (tmp[i] != magic.key[i])
-            throw std::exception("invalid file format");
-
-    magic.version = to_cdf_version(read<int8_t>(*pIS));
-}
-
-//TODO: may refactor this one...
-nc_type to_nc_type(int32_t value) {
-    return static_cast<nc_type>(value);
-}
-
-std::string cdf_reader::read_text() {
-
-    //see: http://www.unidata.ucar.edu/software/netcdf/docs_rc/file_format_specifications.html
-    //TODO: notwithstanding considerations such as character sets, regex, etc
-    std::string text;
-
-    // This is the key to reading a proper name.
-    auto nelems = get_reversed_byte_order(read<int32_t>(*pIS));
-
-    assert(nelems > 0);
-
-    while (nelems--)
-        text += read<int8_t>(*pIS);
-
-    int32_t readCount = text.length();
-
-    while (try_pad_width(readCount))
-        read<int8_t>(*pIS);
-
-    return text;
-}
-
-void cdf_reader::read_named(named & named) {
-    named.name = read_text();
-}
-
-bool cdf_reader::try_read_primitive(value & theValue, nc_type const & type) {
-
-    static const std::set<nc_type> supported = { nc_byte, nc_short, nc_int, nc_float, nc_double };
-
-    // Assert that the type is supported.
-    assert(supported.find(type) != supported.end());
-
-    switch (type) {
-
-    case nc_byte:
-        theValue.primitive.b = read<uint8_t>(*pIS);
-        return true;
-
-    case nc_short:
-        theValue.primitive.s = get_reversed_byte_order(read<int16_t>(*pIS));
-        return true;
-
-    case nc_int:
-        theValue.primitive.i = get_reversed_byte_order(read<int32_t>(*pIS));
-        return true;
-
-    case nc_float:
-        theValue.primitive.f = read<float_t>(*pIS);
-        return true;
-
-    case nc_double:
-        theValue.primitive.d = read<double_t>(*pIS);
-        return true;
-    }
-
-    return false;
-}
-
-value cdf_reader::read_primitive(nc_type const & type) {
-
-    value result;
-
-    assert(try_read_primitive(result, type));
-
-    return result;
-}
-
-bool cdf_reader::try_read_typed_array_prefix(nc_type & type, int32_t & nelems) {
-
-    type = to_nc_type(get_reversed_byte_order(read<int32_t>(*pIS)));
-
-    nelems = get_reversed_byte_order(read<int32_t>(*pIS));
-
-    return type != nc_absent;
-}
-
-void cdf_reader::read_dim(dim & theDim) {
-
-    read_named(theDim);
-
-    theDim.dim_length = get_reversed_byte_order(read<int32_t>(*pIS));
-}
-
-void cdf_reader::read_dims(dim_vector & dims) {
-
-    nc_type type;
-    int32_t nelems;
-
-    if (try_read_typed_array_prefix(type, nelems)) {
-
-        dims = dim_vector(nelems);
-
-        // Assert before and after expectations.
-        assert(type == nc_dimension);
-
-        for (auto & aDim : dims)
-            read_dim(aDim);
-    }
-}
-
-void cdf_reader::read_attr(attr & theAttr) {
-
-    read_named(theAttr);
-
-    //TODO: the examples I am downloading do not appear to adhere to the Classic or 64-bit file format... clearly we're talking at least netCDF-4 (?), maybe later ...
-    theAttr.type = to_nc_type(get_reversed_byte_order(read<int32_t>(*pIS)));
-
-    if (theAttr.get_type() == nc_char) {
-        // 'nelems' is a function of the std::string in this use case.
-        theAttr.set_text(read_text());
-    }
-    else {
-
-        // Otherwise read the values as they were indicated.
-        auto nelems = get_reversed_byte_order(read<int32_t>(*pIS));
-
-        // Allocate the capacity of values and read those in.
-        theAttr.values = value_vector(nelems);
-
-        for (auto & aValue : theAttr.values)
-            assert(try_read_primitive(aValue, theAttr.get_type()));
-    }
-}
-
-void cdf_reader::read_attrs(attr_vector & attrs) {
-
-    nc_type type;
-    int32_t nelems;
-
-    if (try_read_typed_array_prefix(type, nelems)) {
-
-        attrs = attr_vector(nelems);
-
-        // Assert before and after expectations.
-        assert(type == nc_attribute);
-
-        for (auto & anAttr : attrs)
-            read_attr(anAttr);
-    }
-}
-
-void cdf_reader::read_dimids(dimid_vector & dimids) {
-
-    auto nelems = get_reversed_byte_order(read<int32_t>(*pIS));
-
-    dimids = dimid_vector(nelems);
-
-    for (auto i = 0; i < nelems; i++)
-        dimids[i] = get_reversed_byte_order(read<int32_t>(*pIS));
-}
-
-void cdf_reader::read_var_header(var & theVar, dim_vector const & dims, bool useClassic) {
-
-    read_named(theVar);
-
-    read_dimids(theVar.dimids);
-
-    read_attrs(theVar.attrs);
-
-    theVar.type = to_nc_type(get_reversed_byte_order(read<int32_t>(*pIS)));
-
-    //TODO: either redundant and/or obsolete, but still support if possible... maybe with try/catch to protect calculations
-    theVar.vsize = get_reversed_byte_order(read<int32_t>(*pIS));
-
-    /* TODO: TBD: may want to refactor sizeof calculators for verification purposes. This is providing the calculation
-    is correct, which I beleive it is now, and would be a good cross-check, maintaining validity of the file format(s)
-    on the way in/out of processing. */
-
-    /* TODO: TBD: reading "x64" files may be an issue: seems it may be fixed ...
-    http://connect.microsoft.com/VisualStudio/feedback/details/627639/std-fstream-use-32-bit-int-as-pos-type-even-on-x64-platform */
-
-    if (useClassic)
-        theVar.offset.begin = get_reversed_byte_order(read<int32_t>(*pIS));
-    else
-        //TODO: might need to do this one a bit differently (?)
-        theVar.offset.begin64 = get_reversed_byte_order(read<int64_t>(*pIS));
-}
-
-void cdf_reader::read_vars_header(var_vector & vars, dim_vector const & dims, bool useClassic) {
-
-    offset_t current = { 0 };
-
-    nc_type type;
-    int32_t nelems;
-
-    if (try_read_typed_array_prefix(type, nelems)) {
-
-        // Assert before and after expectations.
-        assert(type == nc_variable);
-
-        vars = var_vector(nelems);
-
-        for (auto & aVar : vars) {
-
-            read_var_header(aVar, dims, useClassic);
-
-            //TODO: TBD: is this a dangerous assumption to be making concerning record/non-record data, position in the vector, etc?
-
-            // Verify that the fp values are properly aligned.
-            if (useClassic) {
-                assert(aVar.offset.begin > current.begin);
-                current.begin = aVar.offset.begin;
-            }
-            else {
-                assert(aVar.offset.begin64 > current.begin64);
-                current.begin64 = aVar.offset.begin64;
-            }
-        }
-    }
-}
-
-void cdf_reader::read_var_data(var & theVar, dim_vector const & dims, bool useClassic) {
-
-    const auto way = std::ios::beg;
-
-    if (useClassic)
-        pIS->seekg(theVar.offset.begin, way);
-    else
-        pIS->seekg(theVar.offset.begin64, way);
-
-    const auto type = theVar.get_type();
-    const auto nelems = theVar.vsize / get_primitive_value_size(type);
-
-    theVar.values = value_vector(nelems);
-
-    // A little more efficient than creating on the stack and returning, copying, etc.
-    for (auto & aValue : theVar.values)
-        assert(try_read_primitive(aValue, type));
-}
-
-void cdf_reader::read_vars_data(var_vector & vars, dim_vector const & dims, bool useClassic) {
-
-    // Read the non-record data in header-specified order.
-    for (auto & aVar : vars)
-        if (!aVar.is_record(dims))
-            read_var_data(aVar, dims, useClassic);
-
-    // Then read the record data. Should be only one, but may occur in any position AFAIK.
-    for (auto & aVar : vars)
-        if (aVar.is_record(dims))
-            read_var_data(aVar, dims, useClassic);
-}
-
-cdf_reader & cdf_reader::read_cdf(netcdf & theCdf) {
-
-    read_magic(theCdf.magic);
-
-    //TODO: pick this one up here: look up concerning the BNF format what to expect ...
-    theCdf.numrecs = get_reversed_byte_order(read<int32_t>(*pIS));
-
-    read_dims(theCdf.dims);
-
-    read_attrs(theCdf.attrs);
-
-    const auto useClassic = theCdf.magic.is_classic();
-
-    read_vars_header(theCdf.vars, theCdf.dims, useClassic);
-
-    read_vars_data(theCdf.vars, theCdf.dims, useClassic);
-
-    return *this;
-}
-
-cdf_reader & operator>>(cdf_reader & reader, netcdf & cdf) {
-    return reader.read_cdf(cdf);
-}
+#include "cdf_reader.h"
+#include "cdf_loader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+template<typename _Ty>
+void cdf_reader::read_into(_Ty & x) {
+    input.read(&x, sizeof(x));
+    reverse_byte_order_of(x);
+}
+
+cdf_version to_cdf_version(uint8_t value) {
+    switch (value) {
+    case classic: return classic;
+    case x64: return x64;
+    case x64_data: return x64_data;
+    }
+    throw std::runtime_error("unsupported cdf version");
+}
+
+cdf_reader::cdf_reader(std::istream * pIS, bool reverse_byte_order)
+    : cdf_binary_base(reverse_byte_order)
+    , input(pIS)
+    , pIS(pIS)
+    , file()
+    , handle()
+    , pMemory(nullptr)
+    , nbytes(0)
+    , x64_sizes(false)
+    , staging()
+    , pArena(nullptr) {
+}
+
+cdf_reader::cdf_reader(std::shared_ptr<mapped_file> const & file, bool reverse_byte_order)
+    : cdf_binary_base(reverse_byte_order)
+    , input(file->data(), file->size())
+    , pIS(nullptr)
+    , file(file)
+    , handle()
+    , pMemory(nullptr)
+    , nbytes(0)
+    , x64_sizes(false)
+    , staging()
+    , pArena(nullptr) {
+}
+
+cdf_reader::cdf_reader(std::shared_ptr<random_access_file> const & handle, bool reverse_byte_order)
+    : cdf_binary_base(reverse_byte_order)
+    , input(handle.get())
+    , pIS(nullptr)
+    , file()
+    , handle(handle)
+    , pMemory(nullptr)
+    , nbytes(0)
+    , x64_sizes(false)
+    , staging()
+    , pArena(nullptr) {
+}
+
+cdf_reader::cdf_reader(void const * p, std::size_t n, bool reverse_byte_order)
+    : cdf_binary_base(reverse_byte_order)
+    , input(static_cast<char const *>(p), n)
+    , pIS(nullptr)
+    , file()
+    , handle()
+    , pMemory(static_cast<char const *>(p))
+    , nbytes(n)
+    , x64_sizes(false)
+    , staging()
+    , pArena(nullptr) {
+}
+
+void cdf_reader::read_magic(magic & magic) {
+
+    const auto key_size = sizeof(magic::key_type);
+
+    char tmp[key_size];
+
+    input.read(tmp, key_size);
+
+    for (std::size_t i = 0; i < key_size; i++)
+        if (tmp[i] != magic.key[i])
+            throw std::runtime_error("invalid file format");
+
+    magic.version = to_cdf_version(input.read<int8_t>());
+
+    x64_sizes = magic.has_x64_sizes();
+}
+
+int64_t cdf_reader::read_nelems() {
+
+    if (x64_sizes)
+        return get_reversed_byte_order(input.read<int64_t>());
+
+    return get_reversed_byte_order(input.read<int32_t>());
+}
+
+//TODO: may refactor this one...
+nc_type to_nc_type(int32_t value) {
+    return static_cast<nc_type>(value);
+}
+
+std::string cdf_reader::read_text() {
+
+    //see: http://www.unidata.ucar.edu/software/netcdf/docs_rc/file_format_specifications.html
+    //TODO: notwithstanding considerations such as character sets, regex, etc
+
+    // This is the key to reading a proper name.
+    auto nelems = read_nelems();
+
+    assert(nelems > 0);
+
+    // Read the chars in one go, then skip the padding, if any.
+    std::string text(static_cast<std::string::size_type>(nelems), '\0');
+
+    input.read(&text[0], text.size());
+
+    input.skip(static_cast<block_reader::size_type>(pad_width(nelems) - nelems));
+
+    return text;
+}
+
+void cdf_reader::read_named(named & named) {
+    named.name = read_text();
+}
+
+void cdf_reader::read_values(value_vector & values, nc_type type, int64_t nelems) {
+
+    const auto width = get_primitive_value_size(type);
+    const auto size = static_cast<std::size_t>(nelems * width);
+
+    // The values are padded out to the nearest width, and staged in a block reused from one attr to the next.
+    staging.resize(static_cast<std::size_t>(pad_width(static_cast<int64_t>(size))));
+
+    input.read(staging.data(), staging.size());
+
+    if (reverse_byte_order && width > 1)
+        swap_endian_array(staging.data(), width, static_cast<std::size_t>(nelems));
+
+    values = value_vector(static_cast<value_vector::size_type>(nelems), get_allocator<value>());
+
+    dispatch_primitive(type, [&](auto x) {
+
+        auto src = staging.data();
+
+        for (auto & aValue : values) {
+            std::memcpy(&x, src, sizeof(x));
+            aValue.set(x);
+            src += sizeof(x);
+        }
+    });
+}
+
+bool cdf_reader::try_read_typed_array_prefix(nc_type & type, int64_t & nelems) {
+
+    type = to_nc_type(get_reversed_byte_order(input.read<int32_t>()));
+
+    nelems = read_nelems();
+
+    return type != nc_absent;
+}
+
+void cdf_reader::read_dim(dim & theDim) {
+
+    read_named(theDim);
+
+    theDim.dim_length = read_nelems();
+}
+
+void cdf_reader::read_dims(dim_vector & dims) {
+
+    nc_type type;
+    int64_t nelems;
+
+    if (try_read_typed_array_prefix(type, nelems)) {
+
+        dims = dim_vector(static_cast<dim_vector::size_type>(nelems), get_allocator<dim>());
+
+        // Assert before and after expectations.
+        assert(type == nc_dimension);
+
+        for (auto & aDim : dims)
+            read_dim(aDim);
+    }
+}
+
+void cdf_reader::read_attr(attr & theAttr) {
+
+    read_named(theAttr);
+
+    //TODO: the examples I am downloading do not appear to adhere to the Classic or 64-bit file format... clearly we're talking at least netCDF-4 (?), maybe later ...
+    theAttr.type = to_nc_type(get_reversed_byte_order(input.read<int32_t>()));
+
+    if (theAttr.get_type() == nc_char) {
+        // 'nelems' is a function of the std::string in this use case.
+        theAttr.values = value_vector(get_allocator<value>());
+        theAttr.set_text(read_text());
+    }
+    else {
+
+        // Otherwise read the values as they were indicated.
+        auto nelems = read_nelems();
+
+        read_values(theAttr.values, theAttr.get_type(), nelems);
+    }
+}
+
+void cdf_reader::read_attrs(attr_vector & attrs) {
+
+    nc_type type;
+    int64_t nelems;
+
+    if (try_read_typed_array_prefix(type, nelems)) {
+
+        attrs = attr_vector(static_cast<attr_vector::size_type>(nelems), get_allocator<attr>());
+
+        // Assert before and after expectations.
+        assert(type == nc_attribute);
+
+        for (auto & anAttr : attrs)
+            read_attr(anAttr);
+    }
+}
+
+void cdf_reader::read_dimids(dimid_vector & dimids) {
+
+    const auto nelems = static_cast<dimid_vector::size_type>(read_nelems());
+
+    dimids = dimid_vector(nelems, get_allocator<int32_t>());
+
+    if (!nelems) return;
+
+    if (!x64_sizes) {
+
+        input.read(dimids.data(), nelems * sizeof(int32_t));
+
+        if (reverse_byte_order)
+            swap_endian_array(dimids.data(), sizeof(int32_t), nelems);
+
+        return;
+    }
+
+    // The dimids are INT64 on disk, but index the dims all the same.
+    std::vector<int64_t> wide(nelems);
+
+    input.read(wide.data(), nelems * sizeof(int64_t));
+
+    if (reverse_byte_order)
+        swap_endian_array(wide.data(), sizeof(int64_t), nelems);
+
+    std::copy(wide.begin(), wide.end(), dimids.begin());
+}
+
+void cdf_reader::read_var_header(var & theVar, bool useClassic) {
+
+    read_named(theVar);
+
+    read_dimids(theVar.dimids);
+
+    read_attrs(theVar.attrs);
+
+    theVar.type = to_nc_type(get_reversed_byte_order(input.read<int32_t>()));
+
+    //TODO: either redundant and/or obsolete, but still support if possible... maybe with try/catch to protect calculations
+    // The vsize is unsigned, short of CDF-5, and is all ones when the var is too large for it.
+    theVar.vsize = x64_sizes ? read_nelems() : get_reversed_byte_order(input.read<uint32_t>());
+
+    /* TODO: TBD: may want to refactor sizeof calculators for verification purposes. This is providing the calculation
+    is correct, which I beleive it is now, and would be a good cross-check, maintaining validity of the file format(s)
+    on the way in/out of processing. */
+
+    /* TODO: TBD: reading "x64" files may be an issue: seems it may be fixed ...
+    http://connect.microsoft.com/VisualStudio/feedback/details/627639/std-fstream-use-32-bit-int-as-pos-type-even-on-x64-platform */
+
+    if (useClassic)
+        theVar.offset.begin = get_reversed_byte_order(input.read<int32_t>());
+    else
+        //TODO: might need to do this one a bit differently (?)
+        theVar.offset.begin64 = get_reversed_byte_order(input.read<int64_t>());
+}
+
+void cdf_reader::read_vars_header(var_vector & vars, bool useClassic) {
+
+    nc_type type;
+    int64_t nelems;
+
+    if (try_read_typed_array_prefix(type, nelems)) {
+
+        // Assert before and after expectations.
+        assert(type == nc_variable);
+
+        vars = var_vector(static_cast<var_vector::size_type>(nelems), get_allocator<var>());
+
+        for (auto & aVar : vars) {
+
+            // The vars need not be in data order; record and non-record vars may come in any order.
+            read_var_header(aVar, useClassic);
+        }
+    }
+}
+
+std::shared_ptr<data_loader> cdf_reader::create_loader(netcdf const & theCdf) {
+
+    if (file)
+        return std::make_shared<cdf_loader>(file, reverse_byte_order, theCdf);
+
+    if (handle)
+        return std::make_shared<cdf_loader>(handle, reverse_byte_order, theCdf);
+
+    if (pMemory)
+        return std::make_shared<cdf_loader>(pMemory, nbytes, reverse_byte_order, theCdf);
+
+    return std::make_shared<cdf_loader>(pIS, reverse_byte_order, theCdf);
+}
+
+void cdf_reader::read_vars_data(var_vector & vars, dim_vector const & dims, data_loader & loader) {
+
+    // Read the non-record data in header-specified order.
+    for (auto & aVar : vars)
+        if (!aVar.is_record(dims))
+            loader.load(aVar);
+
+    // Then read the record data, each var gathering its records from across the record section.
+    for (auto & aVar : vars)
+        if (aVar.is_record(dims))
+            loader.load(aVar);
+}
+
+void cdf_reader::skip_to(int64_t pos) {
+
+    const auto here = input.tell();
+
+    if (pos < here)
+        throw std::runtime_error("var data overlaps");
+
+    input.skip(static_cast<block_reader::size_type>(pos - here));
+}
+
+void cdf_reader::read_vars_data_sequential(netcdf & theCdf) {
+
+    typedef data_buffer::size_type size_type;
+
+    auto const & dims = theCdf.dims;
+    const auto useClassic = theCdf.magic.is_classic();
+
+    auto get_begin = [=](var const * pVar) -> int64_t {
+        return useClassic ? pVar->offset.begin : pVar->offset.begin64;
+    };
+
+    auto by_begin = [&](var const * a, var const * b) { return get_begin(a) < get_begin(b); };
+
+    std::vector<var *> fixed_vars;
+    std::vector<var *> record_vars;
+
+    for (auto & aVar : theCdf.vars)
+        (aVar.is_record(dims) ? record_vars : fixed_vars).push_back(&aVar);
+
+    // The vars need not be listed in the order they lie in the file.
+    std::stable_sort(fixed_vars.begin(), fixed_vars.end(), by_begin);
+    std::stable_sort(record_vars.begin(), record_vars.end(), by_begin);
+
+    for (auto pVar : fixed_vars) {
+
+        auto & theData = pVar->data;
+
+        theData.assign_uninitialized(pVar->get_type(), pVar->get_nelems(dims));
+
+        skip_to(get_begin(pVar));
+
+        input.read(theData.data(), theData.size_in_bytes());
+
+        reverse_byte_order_of(theData);
+    }
+
+    if (record_vars.empty()) {
+        if (theCdf.numrecs == netcdf::streaming) theCdf.numrecs = 0;
+        return;
+    }
+
+    const auto records_begin = get_begin(record_vars.front());
+    const auto recsize = static_cast<size_type>(theCdf.get_recsize());
+
+    std::vector<size_type> record_sizes;
+
+    for (auto pVar : record_vars)
+        record_sizes.push_back(pVar->get_nelems(dims) * data_buffer::get_element_size(pVar->get_type()));
+
+    if (theCdf.numrecs == netcdf::streaming) {
+
+        if (!recsize)
+            throw std::runtime_error("unable to determine numrecs");
+
+        skip_to(records_begin);
+
+        /* There is no telling how many records there are short of reading them, so each record is
+        read whole, and taken apart once it is known to be whole; a partial record ends the data. */
+        std::vector<char> record(recsize);
+        std::vector<std::vector<char>> gathered(record_vars.size());
+
+        int64_t numrecs = 0;
+
+        while (input.read_upto(record.data(), recsize) == recsize) {
+
+            for (size_type i = 0; i < record_vars.size(); i++) {
+                auto src = record.data() + (get_begin(record_vars[i]) - records_begin);
+                gathered[i].insert(gathered[i].end(), src, src + record_sizes[i]);
+            }
+
+            numrecs++;
+        }
+
+        theCdf.numrecs = numrecs;
+
+        for (size_type i = 0; i < record_vars.size(); i++) {
+
+            auto & theData = record_vars[i]->data;
+
+            theData.assign_uninitialized(record_vars[i]->get_type(), static_cast<size_type>(numrecs) * (record_sizes[i]
+                / data_buffer::get_element_size(record_vars[i]->get_type())));
+
+            if (!gathered[i].empty())
+                std::memcpy(theData.data(), gathered[i].data(), gathered[i].size());
+
+            reverse_byte_order_of(theData);
+        }
+
+        return;
+    }
+
+    const auto numrecs = static_cast<size_type>(theCdf.numrecs);
+
+    for (size_type i = 0; i < record_vars.size(); i++) {
+        const auto width = data_buffer::get_element_size(record_vars[i]->get_type());
+        record_vars[i]->data.assign_uninitialized(record_vars[i]->get_type(), numrecs * (record_sizes[i] / width));
+    }
+
+    // Record by record, each var's slab of it, in the order they lie within a record.
+    for (size_type r = 0; r < numrecs; r++) {
+        for (size_type i = 0; i < record_vars.size(); i++) {
+
+            auto dest = static_cast<char *>(record_vars[i]->data.data()) + r * record_sizes[i];
+
+            skip_to(get_begin(record_vars[i]) + static_cast<int64_t>(r * recsize));
+
+            input.read(dest, record_sizes[i]);
+        }
+    }
+
+    for (auto pVar : record_vars)
+        reverse_byte_order_of(pVar->data);
+}
+
+cdf_reader & cdf_reader::read_header(netcdf & theCdf) {
+
+    read_cdf_header(theCdf);
+
+    // Leave the data where it is until it is asked for.
+    auto loader = create_loader(theCdf);
+
+    for (auto & aVar : theCdf.vars) {
+        aVar.loader = loader;
+        aVar.unload();
+    }
+
+    return *this;
+}
+
+cdf_reader & cdf_reader::read_header(netcdf & theCdf, memory_arena & arena) {
+
+    pArena = &arena;
+
+    try {
+        read_header(theCdf);
+    }
+    catch (...) {
+        pArena = nullptr;
+        throw;
+    }
+
+    pArena = nullptr;
+
+    return *this;
+}
+
+cdf_reader & cdf_reader::read_cdf(netcdf & theCdf) {
+
+    if (pIS) {
+        read_cdf_header(theCdf, true);
+        read_vars_data_sequential(theCdf);
+        return *this;
+    }
+
+    read_cdf_header(theCdf);
+
+    auto loader = create_loader(theCdf);
+
+    read_vars_data(theCdf.vars, theCdf.dims, *loader);
+
+    return *this;
+}
+
+cdf_reader & cdf_reader::read_cdf(netcdf & theCdf, thread_pool & pool) {
+
+    // There is no spreading a single stream across the pool.
+    if (pIS)
+        return read_cdf(theCdf);
+
+    read_cdf_header(theCdf);
+
+    auto loader = create_loader(theCdf);
+
+    std::vector<var *> vars;
+
+    for (auto & aVar : theCdf.vars)
+        vars.push_back(&aVar);
+
+    loader->load(vars, pool);
+
+    return *this;
+}
+
+void cdf_reader::read_cdf_header(netcdf & theCdf, bool sequential) {
+
+    read_magic(theCdf.magic);
+
+    //TODO: pick this one up here: look up concerning the BNF format what to expect ...
+    theCdf.numrecs = read_nelems();
+
+    read_dims(theCdf.dims);
+
+    read_attrs(theCdf.attrs);
+
+    const auto useClassic = theCdf.magic.is_classic();
+
+    read_vars_header(theCdf.vars, useClassic);
+
+    // Names are looked up by way of an index, built the first time a name is looked up.
+    theCdf.reindex();
+
+    if (theCdf.numrecs == netcdf::streaming && !(sequential && input.get_source_size() < 0))
+        resolve_streaming_numrecs(theCdf);
+}
+
+void cdf_reader::resolve_streaming_numrecs(netcdf & theCdf) {
+
+    const auto useClassic = theCdf.magic.is_classic();
+
+    int64_t records_begin = -1;
+
+    for (auto & aVar : theCdf.vars) {
+        if (aVar.is_record(theCdf.dims)) {
+            const int64_t begin = useClassic ? aVar.offset.begin : aVar.offset.begin64;
+            if (records_begin < 0 || begin < records_begin) records_begin = begin;
+        }
+    }
+
+    // Without record vars there are no records to speak of.
+    if (records_begin < 0) {
+        theCdf.numrecs = 0;
+        return;
+    }
+
+    const auto recsize = theCdf.get_recsize();
+    const auto size = input.get_source_size();
+
+    // Count the whole records there are, short of which there is no telling.
+    if (!recsize || size < 0)
+        throw std::runtime_error("unable to determine numrecs");
+
+    theCdf.numrecs = size > records_begin ? (size - records_begin) / recsize : 0;
+}
+
+cdf_reader & operator>>(cdf_reader & reader, netcdf & cdf) {
+    return reader.read_cdf(cdf);
+}
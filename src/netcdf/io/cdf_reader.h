@@ -1,64 +1,149 @@
-#ifndef NETCDF_CDF_READER_H
-#define NETCDF_CDF_READER_H
-
-#pragma once
-
-#include "../netcdf.h"
-#include "cdf_binary_base.h"
-
-#include <istream>
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct cdf_reader : public cdf_binary_base {
-private:
-
-    std::istream * pIS;
-
-public:
-
-    cdf_reader(std::istream * pIS, bool reverse_byte_order = false);
-
-private:
-
-    void read_magic(magic & magic);
-
-    std::string read_text();
-
-    void read_named(named & named);
-
-    bool try_read_primitive(value & value, nc_type const & type);
-
-    value read_primitive(nc_type const & type);
-
-    bool try_read_typed_array_prefix(nc_type & type, int32_t & nelems);
-
-    void read_dim(dim & aDim);
-
-    void read_dims(dim_vector & dims);
-
-    void read_attr(attr & anAttr);
-
-    void read_attrs(attr_vector & dims);
-
-    void read_dimids(dimid_vector & dimids);
-
-    //TODO: consider whether dims ought not be a first-class part of var_array...
-    void read_var_header(var & aVar, dim_vector const & dims, bool useClassic);
-
-    void read_vars_header(var_vector & vars, dim_vector const & dims, bool useClassic);
-
-    void read_var_data(var & aVar, dim_vector const & dims, bool useClassic);
-
-    void read_vars_data(var_vector & vars, dim_vector const & dims, bool useClassic);
-
-    cdf_reader & read_cdf(netcdf & cdf);
-
-    friend cdf_reader & operator>>(cdf_reader & reader, netcdf & cdf);
-};
-
-///////////////////////////////////////////////////////////////////////////////
-
-cdf_reader & operator>>(cdf_reader & reader, netcdf & cdf);
-
-#endif //NETCDF_CDF_READER_H
+#ifndef NETCDF_CDF_READER_H
+#define NETCDF_CDF_READER_H
+
+#pragma once
+
+#include "../netcdf.h"
+#include "cdf_binary_base.h"
+#include "block_reader.h"
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct cdf_reader : public cdf_binary_base {
+private:
+
+    block_reader input;
+
+    // The input itself, from which the variable data is loaded.
+    std::istream * pIS;
+    std::shared_ptr<mapped_file> file;
+    std::shared_ptr<random_access_file> handle;
+
+    // The memory being read, when reading memory owned by the caller.
+    char const * pMemory;
+    std::size_t nbytes;
+
+    // Set once the magic is read, for CDF-5; see magic::has_x64_sizes.
+    bool x64_sizes;
+
+    // Where attr values are read, in file byte order, on their way into the model.
+    std::vector<char> staging;
+
+    // The arena the header is being read into, if any.
+    memory_arena * pArena;
+
+public:
+
+    /* Reads from the stream in a single pass, front to back: the data is read in file order,
+    gaps are read past, and there is never any seeking, such that the stream may be a pipe, i.e.
+    stdin, or a download or decompressor still under way. Records left STREAMING are counted as
+    they are read, up to the last whole one, when the stream cannot tell its size. Reading just
+    the header, the vars load by seeking, which takes a stream that can. */
+    cdf_reader(std::istream * pIS, bool reverse_byte_order = false);
+
+    /* Reads the header in place from the mapped file. Variable data is not read at all, but
+    viewed straight from the mapping, such that only the pages actually touched are paged in. */
+    cdf_reader(std::shared_ptr<mapped_file> const & file, bool reverse_byte_order = false);
+
+    /* Reads by position from the file. Variable data is read with positional, and for records
+    vectored, reads, which leave the handle free to be shared by any number of readers. */
+    cdf_reader(std::shared_ptr<random_access_file> const & handle, bool reverse_byte_order = false);
+
+    /* Reads the n bytes at p, i.e. a whole file already in memory, in place, the same as a mapped
+    file: nothing is copied on the way in, and variable data in file byte order as it is, i.e.
+    bytes and chars, or when no reversal is asked for, is viewed straight from the memory. The
+    memory belongs to the caller, and must outlive the model, or at least any var viewing it. */
+    cdf_reader(void const * p, std::size_t n, bool reverse_byte_order = false);
+
+    /* Reads the header only: magic, dims, attrs and the var headers. The input stays attached
+    to the vars, each of which loads its data the first time it is asked for; see var::get_data.
+    The input must therefore outlive the model, or at least any var that has yet to load. */
+    cdf_reader & read_header(netcdf & cdf);
+
+    /* As read_header, but the dims, attrs and vars, along with their dimids and attr values, are
+    allocated from the arena, such that the metadata of the file takes a handful of allocations,
+    given back all at once by the arena. The arena must outlive the model, but copies of the model,
+    or of any part of it, are made on the heap. Names and text too long to fit within a string
+    itself are still allocated apart from the arena. */
+    cdf_reader & read_header(netcdf & cdf, memory_arena & arena);
+
+    /* Reads the whole file, loading the vars across the pool. Given a random_access_file, the
+    vars, and the chunks of large vars, are read by position in parallel; see cdf_loader::load. */
+    cdf_reader & read_cdf(netcdf & cdf, thread_pool & pool);
+
+private:
+
+    // Reads the value in place, reversing its byte order there when necessary.
+    template<typename _Ty>
+    void read_into(_Ty & x);
+
+    // Allocates from the arena, when reading into one, otherwise from the heap.
+    template<typename _Ty>
+    arena_allocator<_Ty> get_allocator() const {
+        return arena_allocator<_Ty>(pArena);
+    }
+
+    void read_magic(magic & magic);
+
+    // Reads an nelems, or the like, i.e. INT, or INT64 for CDF-5.
+    int64_t read_nelems();
+
+    std::string read_text();
+
+    void read_named(named & named);
+
+    /* Reads nelems primitive values of the type, and their padding, in one go, reversing their
+    byte order in bulk; the type is switched on once for the lot. */
+    void read_values(value_vector & values, nc_type type, int64_t nelems);
+
+    bool try_read_typed_array_prefix(nc_type & type, int64_t & nelems);
+
+    void read_dim(dim & aDim);
+
+    void read_dims(dim_vector & dims);
+
+    void read_attr(attr & anAttr);
+
+    void read_attrs(attr_vector & dims);
+
+    void read_dimids(dimid_vector & dimids);
+
+    //TODO: consider whether dims ought not be a first-class part of var_array...
+    void read_var_header(var & aVar, bool useClassic);
+
+    void read_vars_header(var_vector & vars, bool useClassic);
+
+    std::shared_ptr<data_loader> create_loader(netcdf const & cdf);
+
+    void read_vars_data(var_vector & vars, dim_vector const & dims, data_loader & loader);
+
+    // Reads past whatever lies between here and pos, which may not be behind.
+    void skip_to(int64_t pos);
+
+    /* Reads the data of every var in the order it lies in the file, non-record vars first, then
+    record by record, moving forward only. */
+    void read_vars_data_sequential(netcdf & cdf);
+
+    /* Reading sequentially, numrecs left STREAMING is left as it is when the input cannot tell
+    its size, for the records to be counted as they are read. */
+    void read_cdf_header(netcdf & cdf, bool sequential = false);
+
+    // Counts the records of a file whose numrecs was left STREAMING, by the size of the file.
+    void resolve_streaming_numrecs(netcdf & cdf);
+
+    cdf_reader & read_cdf(netcdf & cdf);
+
+    friend cdf_reader & operator>>(cdf_reader & reader, netcdf & cdf);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+cdf_reader & operator>>(cdf_reader & reader, netcdf & cdf);
+
+#endif //NETCDF_CDF_READER_H
@@ -1,426 +1,1060 @@
-#include "cdf_writer.h"
-
-#include <functional>
-#include <numeric>
-#include <vector>
-#include <cassert>
-
-///////////////////////////////////////////////////////////////////////////////
-
-cdf_writer::cdf_writer(std::ostream * pOS, bool reverse_byte_order)
-    : cdf_binary_base(reverse_byte_order)
-    , pOS(pOS) {
-}
-
-///////////////////////////////////////////////////////////////////////////////
-
-int32_t __sizeof() {
-    return 0;
-}
-
-int32_t get_nelem() {
-    return 0;
-}
-
-typedef decltype(__sizeof()) sizeof_type;
-
-typedef decltype(get_nelem()) nelem_type;
-
-///////////////////////////////////////////////////////////////////////////////
-
-sizeof_type __sizeof(magic const & theMagic) {
-
-    // magic   := 'C' 'D' 'F'               VERSION_BYTE
-    auto result = sizeof(magic::key_type) + sizeof(theMagic.version);
-    return result;
-}
-
-sizeof_type __sizeof(named const & theNamed) {
-
-    // name    :=        nelems        [chars]
-    auto result = sizeof(nelem_type) + theNamed.name.length();
-    return pad_width(result);
-}
-
-sizeof_type __sizeof(dim const & theDim) {
-
-    // dim     := name
-    auto result = __sizeof(reinterpret_cast<named const &>(theDim))
-        //       <32-bit signed integer, Bigendian, two's complement, with non-negative value>
-        + sizeof(theDim.dim_length);
-    return result;
-}
-
-sizeof_type __sizeof(dim_vector const & dims) {
-
-    // dim_array :=      ABSENT | NC_DIMENSION nelems
-    auto result = sizeof(nc_type) + sizeof(nelem_type)
-        //               [dim ...]
-        + std::accumulate(dims.begin(), dims.end(), static_cast<int32_t>(0),
-        [&](int32_t const & g, dim const & x) { return g + __sizeof(x); });
-    return result;
-}
-
-sizeof_type __sizeof(value const & theValue, nc_type const & type) {
-
-    // values  := [bytes] | [chars] | [shorts] | [ints] | [floats] | [doubles]
-
-    /* This one is a bit different in that we either aggregate
-    several primitive values or a single text (i.e. several chars) value. */
-
-    if (is_primitive_type(type))
-        return get_primitive_value_size(type);
-
-    /* Remember that the nc_type is appart from the value(s)
-    themselves. With char being a bit of a special case. */
-
-    if (type == nc_char)
-        return pad_width(theValue.text.length());
-
-    throw std::exception("unsupported type");
-}
-
-sizeof_type __sizeof(attr const & theAttr) {
-
-    const auto type = theAttr.get_type();
-
-    // attr             := name
-    auto result = __sizeof(reinterpret_cast<named const &>(theAttr))
-        //       nc_type  nelems
-        + sizeof(type) + sizeof(nelem_type);
-
-    /*  The model says we either aggregage a single element vector
-    (chars, or string, text), or a vector of primitives */
-    //                                       [values]
-    auto sizeof_attr_values = std::accumulate(theAttr.values.begin(), theAttr.values.end(),
-        static_cast<sizeof_type>(0),
-        [&](sizeof_type const & g, value const & x) { return g + __sizeof(x, type); });
-
-    // Pad the values out to the nearest width.
-    result += pad_width(sizeof_attr_values);
-
-    return result;
-}
-
-sizeof_type __sizeof(attr_vector const & attrs) {
-
-    // att_array  :=  ABSENT | NC_ATTRIBUTE nelems
-    return sizeof(nc_type) + sizeof(nelem_type)
-        //               [attr ...]
-        + std::accumulate(attrs.begin(), attrs.end(), static_cast<sizeof_type>(0),
-        [&](sizeof_type const & g, attr const & x) { return g + __sizeof(x); });
-}
-
-sizeof_type __sizeof_header(var const & theVar, dim_vector const & dims, bool useClassic) {
-
-    // var     :=          name                                              nelems
-    auto result = __sizeof(reinterpret_cast<named const &>(theVar)) + sizeof(nelem_type);
-
-    //                                      [dimid ...]
-    const auto sizeof_dims = std::accumulate(theVar.dimids.begin(), theVar.dimids.end(),
-        static_cast<sizeof_type>(0),
-        [&](sizeof_type const & g, int32_t const & x) { return g + sizeof(dims[x].dim_length); });
-
-    //                 vatt_array             nc_type               vsize
-    result += __sizeof(theVar.attrs) + sizeof(theVar.type) + sizeof(theVar.vsize);
-
-    //                     OFFSET := <INT with non-negative value> (classic) | <INT64 with non - negative value> (64-bit)
-    const auto sizeof_begin_offset = useClassic ? sizeof(theVar.offset.begin) : sizeof(theVar.offset.begin64);
-
-    return result + sizeof_dims + sizeof_begin_offset;
-}
-
-sizeof_type __sizeof_header(var_vector const & vars, dim_vector const & dims, bool useClassic) {
-
-    // var_array  :=  ABSENT | NC_VARIABLE nelems
-    return sizeof(nc_type) + sizeof(nelem_type)
-        //               [var ...]
-        + std::accumulate(vars.begin(), vars.end(), static_cast<sizeof_type>(0),
-        [&](sizeof_type const & g, var const & x) { return g + __sizeof_header(x, dims, useClassic); });
-}
-
-sizeof_type __sizeof_header(netcdf const & theCdf) {
-
-    // header    := magic
-    return __sizeof(theCdf.magic)
-        //       numrecs
-        + sizeof(theCdf.numrecs)
-        //         dim_array
-        + __sizeof(theCdf.dims)
-        //         gatt_array
-        + __sizeof(theCdf.attrs)
-        //                var_array
-        + __sizeof_header(theCdf.vars, theCdf.dims, theCdf.magic.is_classic());
-}
-
-typedef decltype(var::vsize) vsize_type;
-
-vsize_type __sizeof_data(var const & theVar, dim_vector const & dims, bool useClassic) {
-
-    const auto type = theVar.get_type();
-
-    vsize_type result = get_primitive_value_size(type);
-
-    // http://cucis.ece.northwestern.edu/projects/PnetCDF/CDF-5.html#NOTEVSIZE5
-    // http://cucis.ece.northwestern.edu/projects/PnetCDF/doc/pnetcdf-c/CDF_002d2-file-format-specification.html#NOTEVSIZE
-    if (!theVar.is_record(dims)) {
-        result *= theVar.values.size();
-    }
-    else {
-
-        // Omitting record dimension.
-        auto __normalized = [](decltype(dim::dim_length) len) {return len ? len : 1; };
-
-        result *= std::accumulate(theVar.dimids.begin(), theVar.dimids.end(), static_cast<vsize_type>(1),
-            [&](vsize_type const & g, int32_t const & x) { return g * __normalized(dims[x].dim_length); });
-    }
-
-    return pad_width(result);
-}
-
-///////////////////////////////////////////////////////////////////////////////
-
-void cdf_writer::prepare_var_array(netcdf & theCdf) {
-
-    /* Python netcdf is using the actual file position to inform the begin value
-    then packing that. that's an interesting way of doing it...
-    http://afni.nimh.nih.gov/pub/dist/src/pkundu/meica.libs/nibabel/externals/netcdf.py */
-
-    auto & theVars = theCdf.vars;
-
-    const auto & theDims = theCdf.dims;
-    const auto useClassic = theCdf.magic.is_classic();
-
-    // All of the calculations depend upon the vsize being calculated regardless whether record.
-    for (auto & aVar : theVars)
-        aVar.vsize = __sizeof_data(aVar, theDims, useClassic);
-
-    // This is a little book keeping, that helps the subsequent operations flow much more smoothly.
-    std::vector<var_vector::iterator> record_bms, bms;
-
-    // TODO: TBD: may need/want to rearrange the vars according to record/non-record...
-    // TODO: using the variables, there are how many record data? that can't be right ...
-    for (auto it = theVars.begin(); it != theVars.end(); it++) {
-        if (it->is_record(theDims))
-            record_bms.push_back(it);
-        else
-            bms.push_back(it);
-    }
-
-    // Concatenate the record vars to the end of the non-record vars.
-    bms.insert(bms.end(), record_bms.begin(), record_bms.end());
-
-    // Initialize the current with the size of the header.
-    const auto sizeof_header = __sizeof_header(theCdf);
-    offset_t current = { { sizeof_header } };
-
-    // Calculate the begin offsets for non-record data.
-    for (auto bm = bms.begin(); bm != bms.end(); bm++) {
-
-        // Drill through the bookmark to the true inner iterator.
-        auto var_it = *bm;
-
-        // Just assign the current offset and be on with it.
-        var_it->offset = current;
-
-        // Then simply tally the size with the current offset.
-        if (useClassic)
-            current.begin += var_it->vsize;
-        else
-            current.begin64 += var_it->vsize;
-    }
-}
-
-void cdf_writer::write_magic(magic const & theMagic) {
-
-    for (auto k : theMagic.key)
-        *pOS << k;
-
-    write(*pOS, theMagic.version);
-}
-
-void cdf_writer::write_text(std::string const & theStr) {
-
-    int32_t writtenCount = theStr.length();
-
-    //Starting with the length...
-    write(*pOS, get_reversed_byte_order(static_cast<int32_t>(writtenCount)));
-
-    // Not including the terminating null char as far as I know.
-    for (const auto & c : theStr)
-        write(*pOS, c);
-
-    while (try_pad_width(writtenCount))
-        write(*pOS, static_cast<int8_t>(0x0));
-}
-
-void cdf_writer::write_named(named const & theNamed) {
-    write_text(theNamed.name);
-}
-
-void cdf_writer::write_dim(dim const & theDim) {
-
-    write_named(theDim);
-
-    write(*pOS, get_reversed_byte_order(theDim.dim_length));
-}
-
-void cdf_writer::write_dims(dim_vector const & dims) {
-
-    write_typed_array_prefix(dims, nc_dimension);
-
-    // Followed by the dims themselves.
-    for (const auto & aDim : dims)
-        write_dim(aDim);
-}
-
-void cdf_writer::write_primitive(value const & theValue, nc_type const & type) {
-
-    // This being a special use case, usually.
-    assert(type != nc_char);
-
-    switch (type) {
-
-    default:
-        throw std::exception("unsupported nc_type");
-
-    case nc_byte:
-        write(*pOS, theValue.primitive.b);
-        break;
-
-    case nc_short:
-        write(*pOS, get_reversed_byte_order(theValue.primitive.s));
-        break;
-
-    case nc_int:
-        write(*pOS, get_reversed_byte_order(theValue.primitive.i));
-        break;
-
-    case nc_float:
-        write(*pOS, theValue.primitive.f);
-        break;
-
-    case nc_double:
-        write(*pOS, theValue.primitive.d);
-        break;
-    }
-}
-
-void cdf_writer::write_attr(attr const & theAttr) {
-
-    write_named(theAttr);
-
-    /* TODO: might see about reorganizing the model just a bit: "types" (so-called) really belong
-    close to the value (union, plus other parts, like text) for best language level results. */
-
-    // This is kind of a preculiar use case.
-    const auto type = theAttr.get_type();
-
-    // Handles the text use case especially, followed by the primitive types.
-    if (type == nc_char) {
-
-        assert(theAttr.values.size() == 1);
-
-        write(*pOS, get_reversed_byte_order(type));
-
-        write_text(theAttr.values.front().text);
-    }
-    else {
-
-        write_typed_array_prefix(theAttr.values, type);
-
-        for (const auto & aVar : theAttr.values)
-            write_primitive(aVar, type);
-    }
-}
-
-void cdf_writer::write_attrs(attr_vector const & attrs) {
-
-    write_typed_array_prefix(attrs, nc_attribute);
-
-    for (const auto & anAttr : attrs)
-        write_attr(anAttr);
-}
-
-void cdf_writer::write_var_header(var & theVar, dim_vector const & dims, bool useClassic) {
-
-    write_named(theVar);
-
-    int32_t dimids_nelems = static_cast<int32_t>(theVar.dimids.size());
-    write(*pOS, get_reversed_byte_order(dimids_nelems));
-
-    for (const auto & aDimId : theVar.dimids)
-        write(*pOS, get_reversed_byte_order(aDimId));
-
-    write_attrs(theVar.attrs);
-    
-    write(*pOS, get_reversed_byte_order(theVar.get_type()));
-
-    // Assume that the vsize has already been recalculated.
-    write(*pOS, get_reversed_byte_order(theVar.vsize));
-
-    if (useClassic)
-        write(*pOS, get_reversed_byte_order(theVar.offset.begin));
-    else 
-        write(*pOS, get_reversed_byte_order(theVar.offset.begin64));
-}
-
-void cdf_writer::write_vars_header(var_vector & vars, dim_vector const & dims, bool useClassic) {
-
-    /* TODO: seriously consider whether the struct/container/to-vector pattern isn't adding too much complexity to the overall model,
-    especially considering ctor/dtor times involved, it's a lot of time and overhead that doesn't need to be there ? */
-    write_typed_array_prefix(vars, nc_variable);
-
-    for (auto & v : vars)
-        write_var_header(v, dims, useClassic);
-}
-
-void cdf_writer::write_var_data(var const & theVar, dim_vector const & dims, bool useClassic) {
-
-    auto type = theVar.get_type();
-    //auto nelems = v.get_expected_nelems();
-
-    // A little more efficient than creating on the stack and returning, copying, etc.
-    for (const auto & aValue : theVar.values)
-        write_primitive(aValue, type);
-
-    // Here we do need to take variable data padding into consideration.
-    int32_t writtenCount = theVar.values.size() * get_primitive_value_size(type);
-
-    while (try_pad_width(writtenCount))
-        write(*pOS, static_cast<uint8_t>(0x0));
-}
-
-void cdf_writer::write_vars_data(var_vector const & vars, dim_vector const & dims, bool useClassic) {
-
-    // Read the non-record data in header-specified order.
-    for (const auto & aVar : vars)
-        if (!aVar.is_record(dims))
-            write_var_data(aVar, dims, useClassic);
-
-    // Then read the record data. Should be only one, but may occur in any pOSition AFAIK.
-    for (const auto & aVar : vars)
-        if (aVar.is_record(dims))
-            write_var_data(aVar, dims, useClassic);
-}
-
-cdf_writer & cdf_writer::operator<<(netcdf & theCdf) {
-
-    prepare_var_array(theCdf);
-
-    write_magic(theCdf.magic);
-
-    write(*pOS, get_reversed_byte_order(theCdf.numrecs));
-
-    write_dims(theCdf.dims);
-
-    write_attrs(theCdf.attrs);
-
-    const auto useClassic = theCdf.magic.is_classic();
-
-    write_vars_header(theCdf.vars, theCdf.dims, useClassic);
-
-    write_vars_data(theCdf.vars, theCdf.dims, useClassic);
-
-    return *this;
-}
+#include "cdf_writer.h"
+#include "cdf_loader.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include <cassert>
+
+///////////////////////////////////////////////////////////////////////////////
+
+cdf_writer::cdf_writer(std::ostream * pOS, bool reverse_byte_order)
+    : cdf_binary_base(reverse_byte_order)
+    , pOS(pOS)
+    , file()
+    , header()
+    , staging()
+    , pStreaming(nullptr)
+    , header_pos(-1)
+    , x64_sizes(false) {
+}
+
+cdf_writer::cdf_writer(std::shared_ptr<random_access_file> const & file, bool reverse_byte_order)
+    : cdf_binary_base(reverse_byte_order)
+    , pOS(&header)
+    , file(file)
+    , header()
+    , staging()
+    , pStreaming(nullptr)
+    , header_pos(-1)
+    , x64_sizes(false) {
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int32_t __sizeof() {
+    return 0;
+}
+
+int32_t get_nelem() {
+    return 0;
+}
+
+typedef decltype(__sizeof()) sizeof_type;
+
+typedef decltype(get_nelem()) nelem_type;
+
+///////////////////////////////////////////////////////////////////////////////
+
+sizeof_type __sizeof(magic const & theMagic) {
+
+    // magic   := 'C' 'D' 'F'               VERSION_BYTE
+    auto result = sizeof(magic::key_type) + sizeof(theMagic.version);
+    return result;
+}
+
+/* The nelems fields, dim lengths, dimids and vsize are all one size, INT, or INT64 for CDF-5,
+hence the size is passed along as sizeof_nelems. */
+
+sizeof_type __sizeof(named const & theNamed, sizeof_type sizeof_nelems) {
+
+    // name    :=        nelems        [chars]
+    auto result = sizeof_nelems + static_cast<sizeof_type>(theNamed.name.length());
+    return static_cast<sizeof_type>(pad_width(result));
+}
+
+sizeof_type __sizeof(dim const & theDim, sizeof_type sizeof_nelems) {
+
+    // dim     := name
+    auto result = __sizeof(reinterpret_cast<named const &>(theDim), sizeof_nelems)
+        //       <32-bit signed integer, Bigendian, two's complement, with non-negative value>
+        + sizeof_nelems;
+    return result;
+}
+
+sizeof_type __sizeof(dim_vector const & dims, sizeof_type sizeof_nelems) {
+
+    // dim_array :=      ABSENT | NC_DIMENSION nelems
+    auto result = sizeof(nc_type) + sizeof_nelems
+        //               [dim ...]
+        + std::accumulate(dims.begin(), dims.end(), static_cast<int32_t>(0),
+        [&](int32_t const & g, dim const & x) { return g + __sizeof(x, sizeof_nelems); });
+    return result;
+}
+
+sizeof_type __sizeof(value const & theValue, nc_type const & type) {
+
+    // values  := [bytes] | [chars] | [shorts] | [ints] | [floats] | [doubles]
+
+    /* This one is a bit different in that we either aggregate
+    several primitive values or a single text (i.e. several chars) value. */
+
+    if (is_primitive_type(type))
+        return get_primitive_value_size(type);
+
+    /* Remember that the nc_type is appart from the value(s)
+    themselves. With char being a bit of a special case. */
+
+    if (type == nc_char)
+        return static_cast<sizeof_type>(pad_width(theValue.text.length()));
+
+    throw std::runtime_error("unsupported type");
+}
+
+sizeof_type __sizeof(attr const & theAttr, sizeof_type sizeof_nelems) {
+
+    const auto type = theAttr.get_type();
+
+    // attr             := name
+    auto result = __sizeof(reinterpret_cast<named const &>(theAttr), sizeof_nelems)
+        //       nc_type  nelems
+        + sizeof(type) + sizeof_nelems;
+
+    /*  The model says we either aggregage a single element vector
+    (chars, or string, text), or a vector of primitives */
+    //                                       [values]
+    auto sizeof_attr_values = std::accumulate(theAttr.values.begin(), theAttr.values.end(),
+        static_cast<sizeof_type>(0),
+        [&](sizeof_type const & g, value const & x) { return g + __sizeof(x, type); });
+
+    // Pad the values out to the nearest width.
+    result += static_cast<sizeof_type>(pad_width(sizeof_attr_values));
+
+    return result;
+}
+
+sizeof_type __sizeof(attr_vector const & attrs, sizeof_type sizeof_nelems) {
+
+    // att_array  :=  ABSENT | NC_ATTRIBUTE nelems
+    return sizeof(nc_type) + sizeof_nelems
+        //               [attr ...]
+        + std::accumulate(attrs.begin(), attrs.end(), static_cast<sizeof_type>(0),
+        [&](sizeof_type const & g, attr const & x) { return g + __sizeof(x, sizeof_nelems); });
+}
+
+sizeof_type __sizeof_header(var const & theVar, bool useClassic, sizeof_type sizeof_nelems) {
+
+    // var     :=          name                                              nelems
+    auto result = __sizeof(reinterpret_cast<named const &>(theVar), sizeof_nelems) + sizeof_nelems;
+
+    //                                      [dimid ...]
+    const auto sizeof_dims = static_cast<sizeof_type>(theVar.dimids.size()) * sizeof_nelems;
+
+    //                 vatt_array             nc_type               vsize
+    result += __sizeof(theVar.attrs, sizeof_nelems) + sizeof(theVar.type) + sizeof_nelems;
+
+    //                     OFFSET := <INT with non-negative value> (classic) | <INT64 with non - negative value> (64-bit)
+    const auto sizeof_begin_offset = useClassic ? sizeof(theVar.offset.begin) : sizeof(theVar.offset.begin64);
+
+    return result + sizeof_dims + sizeof_begin_offset;
+}
+
+sizeof_type __sizeof_header(var_vector const & vars, bool useClassic, sizeof_type sizeof_nelems) {
+
+    // var_array  :=  ABSENT | NC_VARIABLE nelems
+    return sizeof(nc_type) + sizeof_nelems
+        //               [var ...]
+        + std::accumulate(vars.begin(), vars.end(), static_cast<sizeof_type>(0),
+        [&](sizeof_type const & g, var const & x) { return g + __sizeof_header(x, useClassic, sizeof_nelems); });
+}
+
+sizeof_type __sizeof_header(netcdf const & theCdf) {
+
+    const sizeof_type sizeof_nelems = theCdf.magic.has_x64_sizes() ? sizeof(int64_t) : sizeof(nelem_type);
+
+    // header    := magic
+    return __sizeof(theCdf.magic)
+        //       numrecs
+        + sizeof_nelems
+        //         dim_array
+        + __sizeof(theCdf.dims, sizeof_nelems)
+        //         gatt_array
+        + __sizeof(theCdf.attrs, sizeof_nelems)
+        //                var_array
+        + __sizeof_header(theCdf.vars, theCdf.magic.is_classic(), sizeof_nelems);
+}
+
+typedef decltype(var::vsize) vsize_type;
+
+vsize_type __sizeof_data(var const & theVar, dim_vector const & dims) {
+
+    const auto type = theVar.get_type();
+
+    vsize_type result = data_buffer::get_element_size(type);
+
+    // http://cucis.ece.northwestern.edu/projects/PnetCDF/CDF-5.html#NOTEVSIZE5
+    // http://cucis.ece.northwestern.edu/projects/PnetCDF/doc/pnetcdf-c/CDF_002d2-file-format-specification.html#NOTEVSIZE
+    if (!theVar.is_record(dims)) {
+        // Data not yet loaded, or none at all, is known only by its dims.
+        result *= theVar.is_loaded() && !theVar.data.empty() ? theVar.data.size() : theVar.get_nelems(dims);
+    }
+    else {
+
+        // Omitting record dimension.
+        auto __normalized = [](decltype(dim::dim_length) len) {return len ? len : 1; };
+
+        result *= std::accumulate(theVar.dimids.begin(), theVar.dimids.end(), static_cast<vsize_type>(1),
+            [&](vsize_type const & g, int32_t const & x) { return g * __normalized(dims[x].dim_length); });
+    }
+
+    return pad_width(result);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void cdf_writer::prepare_var_array(netcdf & theCdf) {
+
+    /* Python netcdf is using the actual file position to inform the begin value
+    then packing that. that's an interesting way of doing it...
+    http://afni.nimh.nih.gov/pub/dist/src/pkundu/meica.libs/nibabel/externals/netcdf.py */
+
+    // Non-record vars are laid out ahead of the record vars, and so they are listed.
+    theCdf.partition_vars();
+
+    auto & theVars = theCdf.vars;
+
+    const auto & theDims = theCdf.dims;
+    const auto useClassic = theCdf.magic.is_classic();
+
+    // All of the calculations depend upon the vsize being calculated regardless whether record.
+    for (auto & aVar : theVars)
+        aVar.vsize = __sizeof_data(aVar, theDims);
+
+    // This is a little book keeping, that helps the subsequent operations flow much more smoothly.
+    std::vector<var_vector::iterator> record_bms, bms;
+
+    // TODO: TBD: may need/want to rearrange the vars according to record/non-record...
+    for (auto it = theVars.begin(); it != theVars.end(); it++) {
+        if (it->is_record(theDims))
+            record_bms.push_back(it);
+        else
+            bms.push_back(it);
+    }
+
+    // Concatenate the record vars to the end of the non-record vars.
+    bms.insert(bms.end(), record_bms.begin(), record_bms.end());
+
+    // Initialize the current with the size of the header.
+    const auto sizeof_header = __sizeof_header(theCdf);
+    offset_t current = { { sizeof_header } };
+
+    /* Calculate the begin offsets for non-record data, followed by record data, whose begin is
+    where its slab of the first record falls; subsequent records follow each recsize apart. */
+    for (auto bm = bms.begin(); bm != bms.end(); bm++) {
+
+        // Drill through the bookmark to the true inner iterator.
+        auto var_it = *bm;
+
+        // Just assign the current offset and be on with it.
+        var_it->offset = current;
+
+        // Then simply tally the size with the current offset.
+        if (useClassic)
+            current.begin += var_it->vsize;
+        else
+            current.begin64 += var_it->vsize;
+    }
+}
+
+void cdf_writer::write_magic(magic const & theMagic) {
+
+    for (auto k : theMagic.key)
+        *pOS << k;
+
+    write(*pOS, theMagic.version);
+
+    x64_sizes = theMagic.has_x64_sizes();
+}
+
+void cdf_writer::write_nelems(int64_t nelems) {
+
+    if (x64_sizes)
+        write(*pOS, get_reversed_byte_order(nelems));
+    else
+        write(*pOS, get_reversed_byte_order(static_cast<int32_t>(nelems)));
+}
+
+void cdf_writer::write_text(std::string const & theStr) {
+
+    int64_t writtenCount = theStr.length();
+
+    //Starting with the length...
+    write_nelems(writtenCount);
+
+    // Not including the terminating null char as far as I know.
+    for (const auto & c : theStr)
+        write(*pOS, c);
+
+    while (try_pad_width(writtenCount))
+        write(*pOS, static_cast<int8_t>(0x0));
+}
+
+void cdf_writer::write_named(named const & theNamed) {
+    write_text(theNamed.name);
+}
+
+void cdf_writer::write_dim(dim const & theDim) {
+
+    write_named(theDim);
+
+    write_nelems(theDim.dim_length);
+}
+
+void cdf_writer::write_dims(dim_vector const & dims) {
+
+    write_typed_array_prefix(dims, nc_dimension);
+
+    // Followed by the dims themselves.
+    for (const auto & aDim : dims)
+        write_dim(aDim);
+}
+
+void cdf_writer::write_values(value_vector const & values, nc_type type) {
+
+    const auto width = get_primitive_value_size(type);
+    const auto size = values.size() * width;
+
+    // The values are padded out to the nearest width, in the staging block.
+    staging.assign(static_cast<std::size_t>(pad_width(static_cast<int64_t>(size))), 0);
+
+    dispatch_primitive(type, [&](auto x) {
+
+        auto dest = staging.data();
+
+        for (auto const & aValue : values) {
+            x = aValue.get<decltype(x)>();
+            std::memcpy(dest, &x, sizeof(x));
+            dest += sizeof(x);
+        }
+    });
+
+    if (reverse_byte_order && width > 1)
+        swap_endian_array(staging.data(), width, values.size());
+
+    pOS->write(staging.data(), staging.size());
+}
+
+void cdf_writer::write_attr(attr const & theAttr) {
+
+    write_named(theAttr);
+
+    /* TODO: might see about reorganizing the model just a bit: "types" (so-called) really belong
+    close to the value (union, plus other parts, like text) for best language level results. */
+
+    // This is kind of a preculiar use case.
+    const auto type = theAttr.get_type();
+
+    // Handles the text use case especially, followed by the primitive types.
+    if (type == nc_char) {
+
+        assert(theAttr.values.size() == 1);
+
+        write(*pOS, get_reversed_byte_order(type));
+
+        write_text(theAttr.values.front().text);
+    }
+    else {
+
+        write_typed_array_prefix(theAttr.values, type);
+
+        write_values(theAttr.values, type);
+    }
+}
+
+void cdf_writer::write_attrs(attr_vector const & attrs) {
+
+    write_typed_array_prefix(attrs, nc_attribute);
+
+    for (const auto & anAttr : attrs)
+        write_attr(anAttr);
+}
+
+void cdf_writer::write_var_header(var & theVar, bool useClassic) {
+
+    write_named(theVar);
+
+    write_nelems(theVar.dimids.size());
+
+    for (const auto & aDimId : theVar.dimids)
+        write_nelems(aDimId);
+
+    write_attrs(theVar.attrs);
+    
+    write(*pOS, get_reversed_byte_order(theVar.get_type()));
+
+    // Assume that the vsize has already been recalculated. Short of CDF-5, a vsize too large for
+    // 32 bits is written as all ones; readers go by the dims in that case.
+    if (x64_sizes)
+        write(*pOS, get_reversed_byte_order(theVar.vsize));
+    else
+        write(*pOS, get_reversed_byte_order(static_cast<uint32_t>(std::min<int64_t>(theVar.vsize, UINT32_MAX))));
+
+    if (useClassic)
+        write(*pOS, get_reversed_byte_order(theVar.offset.begin));
+    else 
+        write(*pOS, get_reversed_byte_order(theVar.offset.begin64));
+}
+
+void cdf_writer::write_vars_header(var_vector & vars, bool useClassic) {
+
+    /* TODO: seriously consider whether the struct/container/to-vector pattern isn't adding too much complexity to the overall model,
+    especially considering ctor/dtor times involved, it's a lot of time and overhead that doesn't need to be there ? */
+    write_typed_array_prefix(vars, nc_variable);
+
+    for (auto & v : vars)
+        write_var_header(v, useClassic);
+}
+
+// Puts the elements in file byte order on their way from src to dest.
+static void encode_elements(char * dest, char const * src, data_buffer::size_type width,
+    data_buffer::size_type nelems, bool reversed) {
+
+    if (reversed && width > 1)
+        swap_endian_array(dest, src, width, nelems);
+    else
+        std::memcpy(dest, src, nelems * width);
+}
+
+/* Whether the bytes of the data are to be reversed on the way out. A view still in file byte
+order, i.e. of a file read reversed, goes out as it is to a file written reversed, and is only
+reversed for one that is not. */
+static bool needs_swap(data_buffer const & theData, bool reversed) {
+    return reversed == theData.is_host_order();
+}
+
+static random_access_file::pos_type get_begin(var const & theVar, bool useClassic) {
+    return useClassic ? theVar.offset.begin : theVar.offset.begin64;
+}
+
+/* Works out where the records begin, and the recsize, from the layout prepare_var_array put
+the record vars in: back to back, padded unless there is just the one. */
+template<typename _Vector>
+static void get_record_layout(_Vector const & record_vars, dim_vector const & dims, bool useClassic,
+    random_access_file::pos_type & records_begin, data_buffer::size_type & recsize) {
+
+    typedef data_buffer::size_type size_type;
+
+    records_begin = -1;
+    recsize = 0;
+
+    const auto padded = record_vars.size() > 1;
+
+    for (auto pVar : record_vars) {
+
+        const auto begin = get_begin(*pVar, useClassic);
+        if (records_begin < 0 || begin < records_begin) records_begin = begin;
+
+        const auto record_size = pVar->get_nelems(dims) * data_buffer::get_element_size(pVar->get_type());
+        recsize += padded ? static_cast<size_type>(pad_width(static_cast<int64_t>(record_size))) : record_size;
+    }
+}
+
+/* Composes count whole records, starting with the first, into dest, which is zeroed beforehand,
+such that the padding, and records the data does not reach, are left as zeros. */
+static void compose_records(char * dest, std::vector<var *> const & record_vars, dim_vector const & dims,
+    bool useClassic, random_access_file::pos_type records_begin, data_buffer::size_type recsize,
+    data_buffer::size_type first_record, data_buffer::size_type count, bool reversed) {
+
+    typedef data_buffer::size_type size_type;
+
+    for (auto pVar : record_vars) {
+
+        const auto offset = static_cast<size_type>(get_begin(*pVar, useClassic) - records_begin);
+        auto const & theData = pVar->data;
+
+        const auto width = data_buffer::get_element_size(pVar->get_type());
+        const auto record_nelems = pVar->get_nelems(dims);
+        auto src = static_cast<char const *>(theData.bytes());
+        const auto swap = needs_swap(theData, reversed);
+
+        for (size_type i = 0; i < count; i++) {
+
+            const auto first = record_nelems * (first_record + i);
+
+            const auto available = theData.size() > first
+                ? std::min(record_nelems, theData.size() - first) : 0;
+
+            encode_elements(dest + i * recsize + offset, src + first * width, width, available, swap);
+        }
+    }
+}
+
+// Large enough that a write takes a handful of calls, small enough not to hold on to much.
+static const data_buffer::size_type staging_size = 1024 * 1024;
+
+// Writes n zeros at pos, gathered from the one block of them, a staging size at a time.
+static void write_zeros_at(random_access_file & theFile, random_access_file::pos_type pos, data_buffer::size_type n) {
+
+    typedef data_buffer::size_type size_type;
+
+    static const char zeros[64 * 1024] = {};
+    static const size_type nblocks = staging_size / sizeof(zeros);
+
+    random_access_file::block blocks[nblocks];
+
+    while (n) {
+
+        size_type count = 0;
+        size_type written = 0;
+
+        for (; count < nblocks && written < n; count++) {
+            blocks[count].data = zeros;
+            blocks[count].size = std::min<size_type>(sizeof(zeros), n - written);
+            written += blocks[count].size;
+        }
+
+        theFile.write_gathered(pos, blocks, count);
+
+        pos += static_cast<random_access_file::pos_type>(written);
+        n -= written;
+    }
+}
+
+void cdf_writer::write_elements(void const * p, data_buffer::size_type width, data_buffer::size_type nelems,
+    data_buffer::size_type padding, bool reversed) {
+
+    typedef data_buffer::size_type size_type;
+
+    auto src = static_cast<const char *>(p);
+
+    if (!reversed || width == 1) {
+        pOS->write(src, nelems * width);
+        write_zeros(padding);
+        return;
+    }
+
+    // Reverse the byte order through a staging block rather than disturb the data itself.
+    const auto nelems_per_block = staging_size / width;
+
+    staging.resize(std::min(nelems_per_block, nelems) * width + padding);
+
+    for (size_type i = 0; i < nelems; i += nelems_per_block) {
+
+        const auto count = std::min(nelems_per_block, nelems - i);
+        auto n = count * width;
+
+        swap_endian_array(staging.data(), src + i * width, width, count);
+
+        // The padding goes out along with the last block.
+        if (i + count == nelems) {
+            std::memset(staging.data() + n, 0, padding);
+            n += padding;
+        }
+
+        pOS->write(staging.data(), n);
+    }
+
+    if (!nelems)
+        write_zeros(padding);
+}
+
+void cdf_writer::write_zeros(data_buffer::size_type n) {
+
+    static const char zeros[4096] = {};
+
+    while (n) {
+        const auto count = std::min<data_buffer::size_type>(n, sizeof(zeros));
+        pOS->write(zeros, count);
+        n -= count;
+    }
+}
+
+void cdf_writer::write_var_data(var & theVar) {
+
+    // Data loaded just for the occasion is released again afterwards.
+    const auto was_loaded = theVar.is_loaded();
+
+    const auto & theData = theVar.get_data();
+
+    // Here we do need to take variable data padding into consideration.
+    const auto total = theData.size_in_bytes();
+    const auto padding = static_cast<data_buffer::size_type>(pad_width(static_cast<int64_t>(total)) - total);
+
+    // Data never set is of no type at all, so the width is the var's own.
+    write_elements(theData.bytes(), data_buffer::get_element_size(theVar.get_type()), theData.size(), padding,
+        needs_swap(theData, reverse_byte_order));
+
+    // A var with no data still takes up its vsize, as zeros.
+    if (theData.empty())
+        write_zeros(static_cast<data_buffer::size_type>(theVar.vsize));
+
+    if (!was_loaded)
+        theVar.unload();
+}
+
+void cdf_writer::write_records(var_vector & vars, dim_vector const & dims, bool useClassic, int64_t numrecs) {
+
+    typedef data_buffer::size_type size_type;
+
+    std::vector<var *> record_vars;
+    std::vector<bool> was_loaded;
+
+    for (auto & aVar : vars) {
+        if (aVar.is_record(dims)) {
+            record_vars.push_back(&aVar);
+            was_loaded.push_back(aVar.is_loaded());
+        }
+    }
+
+    if (record_vars.empty() || numrecs <= 0) return;
+
+    random_access_file::pos_type records_begin;
+    size_type recsize;
+
+    get_record_layout(record_vars, dims, useClassic, records_begin, recsize);
+
+    for (auto pVar : record_vars)
+        pVar->get_data();
+
+    // Runs of whole records are composed in the staging block and written in one go, rather than var by var.
+    const auto step = std::max<size_type>(staging_size / std::max<size_type>(recsize, 1), 1);
+    const auto nrecords = static_cast<size_type>(numrecs);
+
+    for (size_type r = 0; r < nrecords; r += step) {
+
+        const auto count = std::min(step, nrecords - r);
+
+        staging.assign(count * recsize, 0);
+
+        compose_records(staging.data(), record_vars, dims, useClassic, records_begin, recsize, r, count, reverse_byte_order);
+
+        pOS->write(staging.data(), staging.size());
+    }
+
+    for (std::vector<var *>::size_type i = 0; i < record_vars.size(); i++)
+        if (!was_loaded[i])
+            record_vars[i]->unload();
+}
+
+void cdf_writer::write_vars_data(var_vector & vars, dim_vector const & dims, bool useClassic, int64_t numrecs) {
+
+    // Write the non-record data in header-specified order.
+    for (auto & aVar : vars)
+        if (!aVar.is_record(dims))
+            write_var_data(aVar);
+
+    // Then write the record data, interleaved record by record.
+    write_records(vars, dims, useClassic, numrecs);
+}
+
+void cdf_writer::write_header(netcdf & theCdf, int64_t numrecs) {
+
+    prepare_var_array(theCdf);
+
+    write_magic(theCdf.magic);
+
+    write_nelems(numrecs);
+
+    write_dims(theCdf.dims);
+
+    write_attrs(theCdf.attrs);
+
+    write_vars_header(theCdf.vars, theCdf.magic.is_classic());
+}
+
+std::string cdf_writer::compose_header(netcdf & theCdf, int64_t numrecs) {
+
+    // The header is written field by field, so it is put together in memory to go out as one.
+    auto pTarget = pOS;
+
+    pOS = &header;
+    header.str(std::string());
+
+    try {
+        write_header(theCdf, numrecs);
+    }
+    catch (...) {
+        pOS = pTarget;
+        throw;
+    }
+
+    pOS = pTarget;
+
+    return header.str();
+}
+
+void cdf_writer::write_vars_data(var_vector & vars, dim_vector const & dims, bool useClassic, int64_t numrecs, thread_pool * pPool) {
+
+    typedef data_buffer::size_type size_type;
+    typedef random_access_file::pos_type pos_type;
+
+    // Large enough to amortize the call, small enough to spread a single large var across the pool.
+    const size_type chunk_size = 4 * 1024 * 1024;
+
+    const auto reversed = reverse_byte_order;
+    const auto pFile = file.get();
+
+    std::vector<var *> record_vars;
+    std::vector<bool> was_loaded;
+
+    // The writes are waited for apart from anything else on the pool; the record runs refer to record_vars.
+    thread_pool::batch tasks(pPool);
+
+    // Each non-record var is written where prepare_var_array put it, padding and all.
+    for (auto & aVar : vars) {
+
+        if (aVar.is_record(dims)) continue;
+
+        const pos_type pos = get_begin(aVar, useClassic);
+        const auto pVar = &aVar;
+
+        auto write_chunks = [=](char const * src, size_type width, size_type total, size_type first, size_type last, bool swap) {
+
+            static const char zeros[4] = {};
+
+            const auto step = std::max<size_type>(chunk_size / width, 1) * width;
+
+            std::vector<char> buffer;
+
+            for (auto i = first; i < last; i += step) {
+
+                const auto n = std::min(step, last - i);
+
+                // The last chunk carries the padding as well.
+                const auto padding = i + n == total
+                    ? static_cast<size_type>(pad_width(static_cast<int64_t>(total)) - total) : 0;
+
+                // Data already in file byte order goes straight out, gathered with its padding.
+                if (!swap || width == 1) {
+                    const random_access_file::block blocks[] = { { src + i, n }, { zeros, padding } };
+                    pFile->write_gathered(pos + i, blocks, padding ? 2 : 1);
+                    continue;
+                }
+
+                buffer.assign(n + padding, 0);
+                encode_elements(buffer.data(), src + i, width, n / width, swap);
+                pFile->write_at(pos + i, buffer.data(), buffer.size());
+            }
+        };
+
+        if (!aVar.is_loaded()) {
+
+            // Data loaded just for the occasion is released again afterwards, by the same worker.
+            tasks.submit([=]() {
+                auto const & theData = pVar->get_data();
+                const auto total = theData.size_in_bytes();
+                if (total)
+                    write_chunks(static_cast<char const *>(theData.bytes()), data_buffer::get_element_size(pVar->get_type()), total, 0, total,
+                        needs_swap(theData, reversed));
+                else
+                    write_zeros_at(*pFile, pos, static_cast<size_type>(pVar->vsize));
+                pVar->unload();
+            });
+
+            continue;
+        }
+
+        auto const & theData = aVar.data;
+
+        // A var with no data still takes up its vsize, as zeros, such that the file is never short.
+        if (theData.empty()) {
+            const auto vsize = static_cast<size_type>(aVar.vsize);
+            tasks.submit([=]() { write_zeros_at(*pFile, pos, vsize); });
+            continue;
+        }
+
+        // The chunks share the bytes as they are, a view still in file byte order included; nothing is copied.
+        const auto src = static_cast<char const *>(theData.bytes());
+        const auto swap = needs_swap(theData, reversed);
+
+        const auto width = data_buffer::get_element_size(aVar.get_type());
+        const auto total = theData.size_in_bytes();
+        const auto step = std::max<size_type>(chunk_size / width, 1) * width;
+
+        for (size_type first = 0; first < total; first += step) {
+            const auto last = std::min(first + step, total);
+            tasks.submit([=]() { write_chunks(src, width, total, first, last, swap); });
+        }
+    }
+
+    for (auto & aVar : vars) {
+        if (aVar.is_record(dims)) {
+            record_vars.push_back(&aVar);
+            was_loaded.push_back(aVar.is_loaded());
+        }
+    }
+
+    if (!record_vars.empty() && numrecs > 0) {
+
+        pos_type records_begin;
+        size_type recsize;
+
+        get_record_layout(record_vars, dims, useClassic, records_begin, recsize);
+
+        // The record data is needed by every run, so it is loaded up front.
+        for (auto pVar : record_vars)
+            pVar->get_data();
+
+        // Runs of whole records are composed and written in one go, records the data does not reach as zeros.
+        const auto step = std::max<size_type>(chunk_size / std::max<size_type>(recsize, 1), 1);
+        const auto nrecords = static_cast<size_type>(numrecs);
+
+        for (size_type r = 0; r < nrecords; r += step) {
+
+            const auto count = std::min(step, nrecords - r);
+
+            tasks.submit([=, &dims, &record_vars]() {
+
+                std::vector<char> buffer(count * recsize, 0);
+
+                compose_records(buffer.data(), record_vars, dims, useClassic, records_begin, recsize, r, count, reversed);
+
+                pFile->write_at(records_begin + r * recsize, buffer.data(), buffer.size());
+            });
+        }
+    }
+
+    tasks.wait();
+
+    for (std::vector<var *>::size_type i = 0; i < record_vars.size(); i++)
+        if (!was_loaded[i])
+            record_vars[i]->unload();
+}
+
+cdf_writer & cdf_writer::operator<<(netcdf & theCdf) {
+
+    // Written by position all the same, only serially.
+    if (file)
+        return write_cdf(theCdf, nullptr);
+
+    const auto text = compose_header(theCdf, theCdf.numrecs);
+
+    pOS->write(text.data(), text.size());
+
+    write_vars_data(theCdf.vars, theCdf.dims, theCdf.magic.is_classic(), theCdf.numrecs);
+
+    return *this;
+}
+
+cdf_writer & cdf_writer::write_cdf(netcdf & theCdf, thread_pool & pool) {
+
+    if (!file)
+        return *this << theCdf;
+
+    return write_cdf(theCdf, &pool);
+}
+
+cdf_writer & cdf_writer::write_cdf(netcdf & theCdf, thread_pool * pPool) {
+
+    const auto text = compose_header(theCdf, theCdf.numrecs);
+
+    file->write_at(0, text.data(), text.size());
+
+    write_vars_data(theCdf.vars, theCdf.dims, theCdf.magic.is_classic(), theCdf.numrecs, pPool);
+
+    return *this;
+}
+
+cdf_writer & cdf_writer::write_reordered(netcdf & theCdf, var_vector::iterator var_it,
+    netcdf::dim_vector_iterator_vector const & dim_its, thread_pool & pool) {
+
+    typedef data_buffer::size_type size_type;
+
+    if (!file)
+        throw std::runtime_error("reordering as it is written requires a file");
+
+    if (var_it == theCdf.vars.end())
+        throw std::invalid_argument("var not found");
+
+    if (var_it->is_loaded()) {
+        theCdf.reorder_var(var_it, dim_its, pool);
+        return write_cdf(theCdf, pool);
+    }
+
+    const auto axes = theCdf.get_axes(*var_it, dim_its);
+
+    // What it takes to read the var as it was, a slab at a time, from wherever it loads from.
+    auto source = var_it->get_header();
+    source.loader = var_it->loader;
+
+    const auto source_shape = theCdf.get_shape(*var_it);
+    const auto name = var_it->name;
+    const auto type = var_it->get_type();
+
+    // The var is laid out by its dims, and written as zeros, along with the rest; its data goes over them after.
+    theCdf.redim_var(var_it, dim_its);
+
+    var_it->unload();
+    var_it->loader.reset();
+    var_it->data.assign(type, 0);
+
+    write_cdf(theCdf, pool);
+
+    // The vars may have been partitioned on the way.
+    auto & theVar = *theCdf.get_var(name);
+
+    const auto useClassic = theCdf.magic.is_classic();
+    const auto is_record = theVar.is_record(theCdf.dims);
+    const random_access_file::pos_type pos = get_begin(theVar, useClassic);
+    const auto width = data_buffer::get_element_size(type);
+    const auto rank = axes.size();
+
+    // Rows of the var as it is now, i.e. along its first dim, which is a record for a record var.
+    const auto rows = rank ? static_cast<size_type>(source_shape[axes[0]]) : 1;
+
+    size_type row_nelems = 1;
+
+    for (axis_vector::size_type d = 1; d < rank; d++)
+        row_nelems *= static_cast<size_type>(source_shape[axes[d]]);
+
+    const auto row_size = row_nelems * width;
+    const auto recsize = static_cast<size_type>(theCdf.get_recsize());
+
+    const size_type chunk_size = 4 * 1024 * 1024;
+    const auto step = std::max<size_type>(chunk_size / std::max<size_type>(row_size, 1), 1);
+
+    data_buffer original;
+    data_buffer reordered;
+
+    std::vector<char> buffer;
+
+    for (size_type r = 0; r < rows; r += step) {
+
+        const auto n = std::min(step, rows - r);
+
+        // The rows are a slab of the var as it was, along whichever of its dims is now first.
+        slab theSlab(slab::index_vector(rank, 0), source_shape);
+
+        if (rank) {
+            theSlab.start[axes[0]] = static_cast<int64_t>(r);
+            theSlab.count[axes[0]] = static_cast<int64_t>(n);
+        }
+
+        original.assign_uninitialized(type, static_cast<size_type>(theSlab.get_nelems()));
+
+        source.loader->read_slab(source, theSlab, source_shape, original);
+
+        reordered.assign_uninitialized(type, original.size());
+
+        permute_elements(static_cast<data_buffer const &>(original).data(), reordered.data(), width, theSlab.count, axes, pool);
+
+        buffer.resize(reordered.size_in_bytes());
+
+        encode_elements(buffer.data(), static_cast<char const *>(reordered.data()), width, reordered.size(), reverse_byte_order);
+
+        if (!is_record) {
+            file->write_at(pos + static_cast<random_access_file::pos_type>(r * row_size), buffer.data(), buffer.size());
+            continue;
+        }
+
+        for (size_type i = 0; i < n; i++)
+            file->write_at(pos + static_cast<random_access_file::pos_type>((r + i) * recsize), buffer.data() + i * row_size, row_size);
+    }
+
+    // The var loads as it now is, from the file written.
+    theVar.loader = std::make_shared<cdf_loader>(file, reverse_byte_order, theCdf);
+    theVar.unload();
+
+    return *this;
+}
+
+cdf_writer & cdf_writer::write_reordered(netcdf & theCdf, var_vector::size_type i,
+    netcdf::dim_vector_iterator_vector const & dim_its, thread_pool & pool) {
+    return write_reordered(theCdf, theCdf.get_var(i), dim_its, pool);
+}
+
+cdf_writer & cdf_writer::write_reordered(netcdf & theCdf, std::string const & name,
+    netcdf::dim_vector_iterator_vector const & dim_its, thread_pool & pool) {
+    return write_reordered(theCdf, theCdf.get_var(name), dim_its, pool);
+}
+
+void cdf_writer::begin_records(netcdf & theCdf) {
+
+    if (pStreaming)
+        throw std::runtime_error("already streaming records");
+
+    if (file)
+        throw std::runtime_error("streaming records requires an output stream");
+
+    header_pos = pOS->tellp();
+
+    const auto text = compose_header(theCdf, netcdf::streaming);
+
+    pOS->write(text.data(), text.size());
+
+    // There are no records just yet.
+    write_vars_data(theCdf.vars, theCdf.dims, theCdf.magic.is_classic(), 0);
+
+    theCdf.numrecs = 0;
+
+    pStreaming = &theCdf;
+}
+
+void cdf_writer::write_record(var_vector const & vars) {
+
+    typedef data_buffer::size_type size_type;
+
+    if (!pStreaming)
+        throw std::runtime_error("not streaming records");
+
+    auto const & dims = pStreaming->dims;
+    const auto useClassic = pStreaming->magic.is_classic();
+
+    std::vector<var const *> record_vars;
+
+    for (auto & aVar : pStreaming->vars)
+        if (aVar.is_record(dims))
+            record_vars.push_back(&aVar);
+
+    random_access_file::pos_type records_begin;
+    size_type recsize;
+
+    get_record_layout(record_vars, dims, useClassic, records_begin, recsize);
+
+    // The record is composed whole, zeros and padding included, and written in one go.
+    staging.assign(recsize, 0);
+
+    for (auto pVar : record_vars) {
+
+        auto source_it = std::find_if(vars.begin(), vars.end(),
+            [&](var const & x) { return x.name == pVar->name; });
+
+        if (source_it == vars.end()) continue;
+
+        if (source_it->get_type() != pVar->get_type())
+            throw std::invalid_argument("record var type mismatch");
+
+        auto const & theData = source_it->data;
+
+        const auto width = data_buffer::get_element_size(pVar->get_type());
+        const auto available = std::min(pVar->get_nelems(dims), theData.size());
+        const auto offset = static_cast<size_type>(get_begin(*pVar, useClassic) - records_begin);
+
+        encode_elements(staging.data() + offset, static_cast<char const *>(theData.bytes()), width, available,
+            needs_swap(theData, reverse_byte_order));
+    }
+
+    pOS->write(staging.data(), staging.size());
+
+    pStreaming->numrecs++;
+}
+
+void cdf_writer::end_records() {
+
+    if (!pStreaming)
+        throw std::runtime_error("not streaming records");
+
+    pOS->flush();
+
+    // numrecs follows the magic, i.e. 'C' 'D' 'F' VERSION_BYTE.
+    if (header_pos != std::ostream::pos_type(-1)) {
+
+        const auto end_pos = pOS->tellp();
+
+        pOS->seekp(header_pos + std::streamoff(4));
+
+        if (!pOS->fail()) {
+            write_nelems(pStreaming->numrecs);
+            pOS->seekp(end_pos);
+        }
+
+        pOS->clear();
+    }
+
+    pStreaming = nullptr;
+}
@@ -1,78 +1,161 @@
-#ifndef NETCDF_CDF_WRITER_H
-#define NETCDF_CDF_WRITER_H
-
-#pragma once
-
-#include "../netcdf.h"
-#include "cdf_binary_base.h"
-
-#include <ostream>
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct cdf_writer : public cdf_binary_base {
-private:
-
-    std::ostream * pOS;
-
-    bool reverse_byte_order;
-
-public:
-
-    cdf_writer(std::ostream * pOS, bool reverse_byte_order = true);
-
-    cdf_writer & operator<<(netcdf & aCdf);
-
-private:
-
-    // This has to be in the header file on account of the write_typed_array_prefix function.
-    // Otherwise it could be in the source file. We'll guard its access via the private keyword
-    // in the meantime.
-    template<typename _Ty>
-    static std::ostream & write(std::ostream & os, _Ty const & field) {
-        //TODO: consider how to reverse byte order when necessary ...
-        os.write(reinterpret_cast<const char*>(&field), sizeof(field));
-        return os;
-    }
-
-private:
-
-    void prepare_var_array(netcdf & aCdf);
-
-    void write_magic(magic const & aMagic);
-
-    void write_text(std::string const & aStr);
-
-    void write_named(named const & aNamed);
-
-    void write_primitive(value const & aValue, nc_type const & type);
-
-    void write_dim(dim const & aDim);
-
-    void write_dims(dim_vector const & dims);
-
-    void write_attr(attr const & anAttr);
-
-    void write_attrs(attr_vector const & attrs);
-
-    void write_var_header(var & aVar, dim_vector const & dims, bool useClassic);
-
-    void write_vars_header(var_vector & vars, dim_vector const & dims, bool useClassic);
-
-    void write_var_data(var const & aVar, dim_vector const & dims, bool useClassic);
-
-    void write_vars_data(var_vector const & vars, dim_vector const & dims, bool useClassic);
-
-    template<typename _Vector>
-    void write_typed_array_prefix(_Vector const & theValues, nc_type presentType) {
-
-        // Really transparent way of accomplishing this...
-        int32_t type = theValues.size() ? presentType : nc_absent;
-        write(*pOS, get_reversed_byte_order(type));
-
-        int32_t nelems = theValues.size();
-        write(*pOS, get_reversed_byte_order(nelems));
-    }
-};
-
-#endif //NETCDF_CDF_WRITER_H
+#ifndef NETCDF_CDF_WRITER_H
+#define NETCDF_CDF_WRITER_H
+
+#pragma once
+
+#include "../netcdf.h"
+#include "cdf_binary_base.h"
+#include "random_access_file.h"
+
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct cdf_writer : public cdf_binary_base {
+private:
+
+    std::ostream * pOS;
+
+    /* The header is composed here, to be written in one go; given a file, the data is then
+    written to the file by position. */
+    std::shared_ptr<random_access_file> file;
+    std::ostringstream header;
+
+    /* Where data is put in file byte order on its way out, when it is not already, and where
+    runs of records are composed, such that the data goes out in large blocks. */
+    std::vector<char> staging;
+
+    // The model being streamed, if any, and where its header began, if the output can tell.
+    netcdf * pStreaming;
+    std::ostream::pos_type header_pos;
+
+    // Set once the magic is written, for CDF-5; see magic::has_x64_sizes.
+    bool x64_sizes;
+
+public:
+
+    cdf_writer(std::ostream * pOS, bool reverse_byte_order = true);
+
+    /* Writes to the file by position, which leaves the data of each var free to be written
+    independently of the others, at the offset prepare_var_array worked out for it. */
+    cdf_writer(std::shared_ptr<random_access_file> const & file, bool reverse_byte_order = true);
+
+    cdf_writer & operator<<(netcdf & aCdf);
+
+    /* Writes the header, then spreads the data across the pool: each non-record var, or chunk of
+    a large one, and each run of whole records, is put in file byte order, padded, and written
+    to its offset on its own thread. Short of a file, this is the same as operator<<. */
+    cdf_writer & write_cdf(netcdf & aCdf, thread_pool & pool);
+
+    /* Writes the model as write_cdf does, but with the dims of the var in the order given, and its
+    data along with them; see netcdf::reorder_var. A var not loaded is reordered on its way from
+    wherever it loads from to the file, a slab of rows at a time, each slab put in order across
+    the pool, such that it is never held in memory whole, however large; it is then left to load
+    from the file written. A loaded var is simply reordered in memory first. Takes a file. */
+    cdf_writer & write_reordered(netcdf & aCdf, var_vector::iterator var_it, netcdf::dim_vector_iterator_vector const & dim_its, thread_pool & pool);
+    cdf_writer & write_reordered(netcdf & aCdf, var_vector::size_type i, netcdf::dim_vector_iterator_vector const & dim_its, thread_pool & pool);
+    cdf_writer & write_reordered(netcdf & aCdf, std::string const & name, netcdf::dim_vector_iterator_vector const & dim_its, thread_pool & pool);
+
+    /* Streams the records rather than writing them all at once. The header is written up front,
+    with numrecs as STREAMING, along with the non-record data; the record vars need no data at
+    all, since their vsize comes from the dims. Records are then written one at a time, straight
+    to the output, and numrecs is patched at the end when the output is seekable, otherwise it
+    is left STREAMING, for the reader to work out from the size of the file. */
+    void begin_records(netcdf & aCdf);
+
+    /* Writes the next record, taking each record var's slab from the first record of the var
+    of the same name; record vars not given are written as zeros. */
+    void write_record(var_vector const & vars);
+
+    void end_records();
+
+    /* Works out the vsize and begin of every var, as they are about to be written. Every write
+    does this first; it is public so that the layout may be had, or measured, without writing. */
+    void prepare_var_array(netcdf & aCdf);
+
+private:
+
+    // This has to be in the header file on account of the write_typed_array_prefix function.
+    // Otherwise it could be in the source file. We'll guard its access via the private keyword
+    // in the meantime.
+    template<typename _Ty>
+    static std::ostream & write(std::ostream & os, _Ty const & field) {
+        //TODO: consider how to reverse byte order when necessary ...
+        os.write(reinterpret_cast<const char*>(&field), sizeof(field));
+        return os;
+    }
+
+    // Writes a copy of the value with its byte order reversed, when necessary, in place.
+    template<typename _Ty>
+    void write_reversed(_Ty const & x) {
+        auto local = x;
+        reverse_byte_order_of(local);
+        write(*pOS, local);
+    }
+
+private:
+
+    void write_magic(magic const & aMagic);
+
+    // Writes an nelems, or the like, i.e. INT, or INT64 for CDF-5.
+    void write_nelems(int64_t nelems);
+
+    void write_text(std::string const & aStr);
+
+    void write_named(named const & aNamed);
+
+    /* Writes the primitive values of the type, and their padding, in one go, reversing their
+    byte order in bulk; the type is switched on once for the lot. */
+    void write_values(value_vector const & values, nc_type type);
+
+    void write_dim(dim const & aDim);
+
+    void write_dims(dim_vector const & dims);
+
+    void write_attr(attr const & anAttr);
+
+    void write_attrs(attr_vector const & attrs);
+
+    void write_var_header(var & aVar, bool useClassic);
+
+    void write_vars_header(var_vector & vars, bool useClassic);
+
+    // Writes the elements, reversing their byte order if need be, followed by as many bytes of padding.
+    void write_elements(void const * p, data_buffer::size_type width, data_buffer::size_type nelems,
+        data_buffer::size_type padding, bool reversed);
+
+    void write_zeros(data_buffer::size_type n);
+
+    void write_var_data(var & aVar);
+
+    void write_records(var_vector & vars, dim_vector const & dims, bool useClassic, int64_t numrecs);
+
+    void write_vars_data(var_vector & vars, dim_vector const & dims, bool useClassic, int64_t numrecs);
+
+    void write_header(netcdf & aCdf, int64_t numrecs);
+
+    // Writes the header into memory rather than to the output, returning it whole.
+    std::string compose_header(netcdf & aCdf, int64_t numrecs);
+
+    /* Writes the data by position, as write_cdf does, across the pool; short of one, the same
+    tasks run one after another on the caller's thread. */
+    void write_vars_data(var_vector & vars, dim_vector const & dims, bool useClassic, int64_t numrecs, thread_pool * pPool);
+
+    cdf_writer & write_cdf(netcdf & aCdf, thread_pool * pPool);
+
+    template<typename _Vector>
+    void write_typed_array_prefix(_Vector const & theValues, nc_type presentType) {
+
+        // Really transparent way of accomplishing this...
+        int32_t type = theValues.size() ? presentType : nc_absent;
+        write(*pOS, get_reversed_byte_order(type));
+
+        write_nelems(theValues.size());
+    }
+};
+
+#endif //NETCDF_CDF_WRITER_H
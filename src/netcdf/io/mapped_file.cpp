@@ -0,0 +1,106 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(std::string const & path)
+    : hFile(INVALID_HANDLE_VALUE)
+    , hMapping(nullptr)
+    , pdata(nullptr)
+    , nbytes(0) {
+
+    hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("unable to open file");
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(hFile, &size)) {
+        CloseHandle(hFile);
+        throw std::runtime_error("unable to size file");
+    }
+
+    nbytes = static_cast<size_type>(size.QuadPart);
+
+    // There is no mapping an empty file; leave it with no data.
+    if (!nbytes) return;
+
+    hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (hMapping)
+        pdata = static_cast<char const *>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+
+    if (!pdata) {
+        if (hMapping) CloseHandle(hMapping);
+        CloseHandle(hFile);
+        throw std::runtime_error("unable to map file");
+    }
+}
+
+mapped_file::~mapped_file() {
+    if (pdata) UnmapViewOfFile(pdata);
+    if (hMapping) CloseHandle(hMapping);
+    if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+}
+
+#else
+
+mapped_file::mapped_file(std::string const & path)
+    : fd(-1)
+    , pdata(nullptr)
+    , nbytes(0) {
+
+    fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        throw std::runtime_error("unable to open file");
+
+    struct stat st;
+
+    if (fstat(fd, &st)) {
+        close(fd);
+        throw std::runtime_error("unable to size file");
+    }
+
+    nbytes = static_cast<size_type>(st.st_size);
+
+    // There is no mapping an empty file; leave it with no data.
+    if (!nbytes) return;
+
+    auto p = mmap(nullptr, nbytes, PROT_READ, MAP_SHARED, fd, 0);
+
+    if (p == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("unable to map file");
+    }
+
+    pdata = static_cast<char const *>(p);
+}
+
+mapped_file::~mapped_file() {
+    if (pdata) munmap(const_cast<char *>(pdata), nbytes);
+    if (fd >= 0) close(fd);
+}
+
+#endif
+
+char const * mapped_file::data() const {
+    return pdata;
+}
+
+mapped_file::size_type mapped_file::size() const {
+    return nbytes;
+}
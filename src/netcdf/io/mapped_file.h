@@ -0,0 +1,41 @@
+#ifndef NETCDF_MAPPED_FILE_H
+#define NETCDF_MAPPED_FILE_H
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Maps a whole file, read-only, into the address space. Nothing is actually read until the
+pages are touched, so the cost of any one access is the pages that it spans, not the file. */
+struct mapped_file {
+
+    typedef std::size_t size_type;
+
+    mapped_file(std::string const & path);
+
+    virtual ~mapped_file();
+
+    char const * data() const;
+
+    size_type size() const;
+
+private:
+
+    mapped_file(mapped_file const &) {}
+
+#ifdef _WIN32
+    void * hFile;
+    void * hMapping;
+#else
+    int fd;
+#endif
+
+    char const * pdata;
+
+    size_type nbytes;
+};
+
+#endif //NETCDF_MAPPED_FILE_H
@@ -1,16 +1,289 @@
-#include "network_byte_order.h"
-
-#include <cstdint>
-
-bool is_big_endian() {
-
-    static const uint32_t val = 0x01;
-
-    static const char * pval = reinterpret_cast<const char *>(&val);
-
-    return pval[0] == 0;
-}
-
-bool is_little_endian() {
-    return !is_big_endian();
-}
+#include "network_byte_order.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define NETCDF_SWAP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NETCDF_SWAP_TARGET(features)
+#else
+#define NETCDF_SWAP_TARGET(features) __attribute__((target(features)))
+#endif
+#endif
+
+bool is_big_endian() {
+
+    static const uint32_t val = 0x01;
+
+    static const char * pval = reinterpret_cast<const char *>(&val);
+
+    return pval[0] == 0;
+}
+
+bool is_little_endian() {
+    return !is_big_endian();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+typedef void(*swap_kernel)(uint8_t * dest, uint8_t const * src, std::size_t nelems);
+
+inline uint16_t byte_swap(uint16_t x) {
+    return static_cast<uint16_t>((x >> 8) | (x << 8));
+}
+
+inline uint32_t byte_swap(uint32_t x) {
+    return (x >> 24) | ((x >> 8) & 0x0000ff00u) | ((x << 8) & 0x00ff0000u) | (x << 24);
+}
+
+inline uint64_t byte_swap(uint64_t x) {
+    return (static_cast<uint64_t>(byte_swap(static_cast<uint32_t>(x))) << 32)
+        | byte_swap(static_cast<uint32_t>(x >> 32));
+}
+
+// Going through memcpy keeps unaligned data well defined; compilers reduce it to a load and a bswap.
+template<typename _Uint>
+void swap_portable_kernel(uint8_t * dest, uint8_t const * src, std::size_t nelems) {
+    for (std::size_t i = 0; i < nelems; i++) {
+        _Uint x;
+        memcpy(&x, src + i * sizeof(x), sizeof(x));
+        x = byte_swap(x);
+        memcpy(dest + i * sizeof(x), &x, sizeof(x));
+    }
+}
+
+#ifdef NETCDF_SWAP_X86
+
+// Shuffle control reversing each width byte element of a 16 byte lane.
+template<std::size_t _Width>
+__m128i get_swap_mask() {
+    uint8_t mask[16];
+    for (auto i = 0; i < 16; i++)
+        mask[i] = static_cast<uint8_t>((i / _Width) * _Width + (_Width - 1 - i % _Width));
+    __m128i result;
+    memcpy(&result, mask, sizeof(result));
+    return result;
+}
+
+template<typename _Uint>
+NETCDF_SWAP_TARGET("ssse3")
+void swap_ssse3_kernel(uint8_t * dest, uint8_t const * src, std::size_t nelems) {
+
+    const auto mask = get_swap_mask<sizeof(_Uint)>();
+    const auto nbytes = nelems * sizeof(_Uint);
+
+    std::size_t i = 0;
+
+    for (; i + 64 <= nbytes; i += 64) {
+        auto a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i + 16));
+        auto c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i + 32));
+        auto d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i + 48));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_shuffle_epi8(a, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i + 16), _mm_shuffle_epi8(b, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i + 32), _mm_shuffle_epi8(c, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i + 48), _mm_shuffle_epi8(d, mask));
+    }
+
+    for (; i + 16 <= nbytes; i += 16) {
+        auto a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_shuffle_epi8(a, mask));
+    }
+
+    swap_portable_kernel<_Uint>(dest + i, src + i, (nbytes - i) / sizeof(_Uint));
+}
+
+template<typename _Uint>
+NETCDF_SWAP_TARGET("avx2")
+void swap_avx2_kernel(uint8_t * dest, uint8_t const * src, std::size_t nelems) {
+
+    // The 256-bit shuffle works within each 128-bit lane, so the same control serves both.
+    const auto lane = get_swap_mask<sizeof(_Uint)>();
+    const auto mask = _mm256_inserti128_si256(_mm256_castsi128_si256(lane), lane, 1);
+    const auto nbytes = nelems * sizeof(_Uint);
+
+    std::size_t i = 0;
+
+    for (; i + 128 <= nbytes; i += 128) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i + 32));
+        auto c = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i + 64));
+        auto d = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i + 96));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i), _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i + 32), _mm256_shuffle_epi8(b, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i + 64), _mm256_shuffle_epi8(c, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i + 96), _mm256_shuffle_epi8(d, mask));
+    }
+
+    for (; i + 32 <= nbytes; i += 32) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i), _mm256_shuffle_epi8(a, mask));
+    }
+
+    swap_portable_kernel<_Uint>(dest + i, src + i, (nbytes - i) / sizeof(_Uint));
+}
+
+bool has_cpu_feature(swap_engine engine) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    const auto max_leaf = info[0];
+    __cpuid(info, 1);
+    const auto ssse3 = (info[2] & (1 << 9)) != 0;
+    const auto os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+    if (engine == swap_ssse3) return ssse3;
+    if (max_leaf < 7 || !os_avx) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return engine == swap_ssse3
+        ? __builtin_cpu_supports("ssse3") != 0
+        : __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif //NETCDF_SWAP_X86
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct swap_kernels {
+    swap_engine engine;
+    swap_kernel x2;
+    swap_kernel x4;
+    swap_kernel x8;
+};
+
+// One table per engine, fixed at compile time, such that the current one may be swapped by pointer.
+const swap_kernels portable_kernels = { swap_portable, swap_portable_kernel<uint16_t>, swap_portable_kernel<uint32_t>, swap_portable_kernel<uint64_t> };
+
+#ifdef NETCDF_SWAP_X86
+const swap_kernels ssse3_kernels = { swap_ssse3, swap_ssse3_kernel<uint16_t>, swap_ssse3_kernel<uint32_t>, swap_ssse3_kernel<uint64_t> };
+const swap_kernels avx2_kernels = { swap_avx2, swap_avx2_kernel<uint16_t>, swap_avx2_kernel<uint32_t>, swap_avx2_kernel<uint64_t> };
+#endif
+
+swap_kernels const * get_swap_kernels(swap_engine engine) {
+
+#ifdef NETCDF_SWAP_X86
+    switch (engine) {
+    case swap_avx2: return &avx2_kernels;
+    case swap_ssse3: return &ssse3_kernels;
+    case swap_portable: break;
+    }
+#endif
+
+    return &portable_kernels;
+}
+
+swap_kernels const * select_swap_kernels() {
+
+    if (is_swap_engine_supported(swap_avx2))
+        return get_swap_kernels(swap_avx2);
+
+    if (is_swap_engine_supported(swap_ssse3))
+        return get_swap_kernels(swap_ssse3);
+
+    return get_swap_kernels(swap_portable);
+}
+
+/* The engine may be set while other threads are swapping, each of which goes by whichever table
+it loaded, the tables themselves never changing. Null until first used, such that the CPU is not
+asked about before static initialization is done. */
+std::atomic<swap_kernels const *> current_swap_kernels(nullptr);
+
+swap_kernels const & get_current_swap_kernels() {
+
+    auto p = current_swap_kernels.load(std::memory_order_acquire);
+
+    if (!p) {
+
+        swap_kernels const * expected = nullptr;
+
+        p = select_swap_kernels();
+
+        // An engine set meanwhile wins over the one selected here.
+        if (!current_swap_kernels.compare_exchange_strong(expected, p, std::memory_order_acq_rel))
+            p = expected;
+    }
+
+    return *p;
+}
+
+bool is_swap_engine_supported(swap_engine engine) {
+
+    if (engine == swap_portable) return true;
+
+#ifdef NETCDF_SWAP_X86
+    return has_cpu_feature(engine);
+#else
+    return false;
+#endif
+}
+
+swap_engine get_swap_engine() {
+    return get_current_swap_kernels().engine;
+}
+
+bool set_swap_engine(swap_engine engine) {
+
+    if (!is_swap_engine_supported(engine))
+        return false;
+
+    current_swap_kernels.store(get_swap_kernels(engine), std::memory_order_release);
+
+    return true;
+}
+
+const char * get_swap_engine_name(swap_engine engine) {
+    switch (engine) {
+    case swap_avx2: return "avx2";
+    case swap_ssse3: return "ssse3";
+    case swap_portable: return "portable";
+    }
+    return "portable";
+}
+
+void swap_endian_array(void * p, std::size_t width, std::size_t nelems) {
+    swap_endian_array(p, p, width, nelems);
+}
+
+void swap_endian_array(void * dest, void const * src, std::size_t width, std::size_t nelems) {
+
+    auto pdest = static_cast<uint8_t *>(dest);
+    auto psrc = static_cast<uint8_t const *>(src);
+
+    auto const & kernels = get_current_swap_kernels();
+
+    switch (width) {
+
+    case 1:
+        // Nothing to reverse, but honor the copy.
+        if (pdest != psrc) memcpy(pdest, psrc, nelems);
+        break;
+
+    case 2:
+        kernels.x2(pdest, psrc, nelems);
+        break;
+
+    case 4:
+        kernels.x4(pdest, psrc, nelems);
+        break;
+
+    case 8:
+        kernels.x8(pdest, psrc, nelems);
+        break;
+
+    default:
+        for (std::size_t i = 0; i < nelems; i++, pdest += width, psrc += width) {
+            if (pdest == psrc)
+                std::reverse(pdest, pdest + width);
+            else
+                std::reverse_copy(psrc, psrc + width, pdest);
+        }
+        break;
+    }
+}
@@ -1,18 +1,46 @@
-#ifndef NETWORK_BYTE_ORDER_H
-#define NETWORK_BYTE_ORDER_H
-
-#pragma once
-
-#include <algorithm>
-
-bool is_little_endian();
-bool is_big_endian();
-
-template <typename _Ty>
-_Ty swap_endian(_Ty & x) {
-    char & raw = reinterpret_cast<char &>(x);
-    std::reverse(&raw, &raw + sizeof(_Ty));
-    return x;
-}
-
-#endif //NETWORK_BYTE_ORDER_H
+#ifndef NETWORK_BYTE_ORDER_H
+#define NETWORK_BYTE_ORDER_H
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+bool is_little_endian();
+bool is_big_endian();
+
+template <typename _Ty>
+_Ty swap_endian(_Ty & x) {
+    char & raw = reinterpret_cast<char &>(x);
+    std::reverse(&raw, &raw + sizeof(_Ty));
+    return x;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Bulk byte order reversal for whole arrays of 2, 4 or 8 byte wide elements. The engine that
+does the work is chosen once at runtime from the CPU features: AVX2 or SSSE3 byte shuffles when
+available, otherwise the portable fallback. It may also be forced, i.e. for comparison purposes. */
+enum swap_engine {
+    swap_portable,
+    swap_ssse3,
+    swap_avx2
+};
+
+bool is_swap_engine_supported(swap_engine engine);
+
+swap_engine get_swap_engine();
+
+/* Returns false, leaving the current engine in place, when the CPU does not support the one asked for.
+May be called at any time; a swap already under way finishes on the engine it started with. */
+bool set_swap_engine(swap_engine engine);
+
+const char * get_swap_engine_name(swap_engine engine);
+
+// Reverses the byte order of nelems elements of the given width, in place.
+void swap_endian_array(void * p, std::size_t width, std::size_t nelems);
+
+// Same, but from src to dest, which must either be the same or not overlap at all.
+void swap_endian_array(void * dest, void const * src, std::size_t width, std::size_t nelems);
+
+#endif //NETWORK_BYTE_ORDER_H
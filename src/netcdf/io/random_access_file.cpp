@@ -0,0 +1,291 @@
+#include "random_access_file.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+random_access_file::random_access_file(std::string const & path, open_mode mode)
+    : hFile(INVALID_HANDLE_VALUE) {
+
+    const DWORD access = mode == read_only ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+    const DWORD disposition = mode == create ? CREATE_ALWAYS : OPEN_EXISTING;
+
+    hFile = CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("unable to open file");
+}
+
+random_access_file::~random_access_file() {
+    if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+}
+
+random_access_file::size_type random_access_file::read_at(pos_type pos, void * dest, size_type n) const {
+
+    auto p = static_cast<char *>(dest);
+    size_type result = 0;
+
+    while (result < n) {
+
+        // The position goes in the overlapped structure, leaving the file pointer alone.
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(pos);
+        overlapped.OffsetHigh = static_cast<DWORD>(pos >> 32);
+
+        const auto chunk = static_cast<DWORD>(std::min<size_type>(n - result, 1 << 30));
+        DWORD count = 0;
+
+        if (!ReadFile(hFile, p + result, chunk, &count, &overlapped)) {
+            if (GetLastError() == ERROR_HANDLE_EOF) break;
+            throw std::runtime_error("unable to read file");
+        }
+
+        if (!count) break;
+
+        result += count;
+        pos += count;
+    }
+
+    return result;
+}
+
+void random_access_file::write_at(pos_type pos, void const * src, size_type n) {
+
+    auto p = static_cast<char const *>(src);
+
+    while (n) {
+
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(pos);
+        overlapped.OffsetHigh = static_cast<DWORD>(pos >> 32);
+
+        const auto chunk = static_cast<DWORD>(std::min<size_type>(n, 1 << 30));
+        DWORD count = 0;
+
+        if (!WriteFile(hFile, p, chunk, &count, &overlapped) || !count)
+            throw std::runtime_error("unable to write file");
+
+        p += count;
+        pos += count;
+        n -= count;
+    }
+}
+
+random_access_file::pos_type random_access_file::size() const {
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(hFile, &size))
+        throw std::runtime_error("unable to size file");
+
+    return size.QuadPart;
+}
+
+void random_access_file::write_gathered(pos_type pos, block const * blocks, size_type count) {
+
+    // WriteFileGather takes only whole pages, to a file opened unbuffered, so each block is written in turn.
+    for (size_type i = 0; i < count; pos += blocks[i].size, i++)
+        write_at(pos, blocks[i].data, blocks[i].size);
+}
+
+void random_access_file::read_strided(pos_type pos, pos_type stride, size_type n, size_type count, void * dest) const {
+
+    // Likewise ReadFileScatter, such that the runs are read one at a time, gaps or no gaps.
+    auto p = static_cast<char *>(dest);
+
+    for (size_type i = 0; i < count; i++, pos += stride, p += n)
+        if (read_at(pos, p, n) != n)
+            throw std::runtime_error("unexpected end of file");
+}
+
+#else
+
+random_access_file::random_access_file(std::string const & path, open_mode mode)
+    : fd(-1) {
+
+    const int flags = mode == read_only ? O_RDONLY
+        : mode == read_write ? O_RDWR
+        : O_RDWR | O_CREAT | O_TRUNC;
+
+    fd = open(path.c_str(), flags, 0644);
+
+    if (fd < 0)
+        throw std::runtime_error("unable to open file");
+}
+
+random_access_file::~random_access_file() {
+    if (fd >= 0) close(fd);
+}
+
+random_access_file::size_type random_access_file::read_at(pos_type pos, void * dest, size_type n) const {
+
+    auto p = static_cast<char *>(dest);
+    size_type result = 0;
+
+    while (result < n) {
+
+        const auto count = pread(fd, p + result, n - result, static_cast<off_t>(pos + result));
+
+        if (count < 0)
+            throw std::runtime_error("unable to read file");
+
+        if (!count) break;
+
+        result += static_cast<size_type>(count);
+    }
+
+    return result;
+}
+
+void random_access_file::write_at(pos_type pos, void const * src, size_type n) {
+
+    auto p = static_cast<char const *>(src);
+
+    while (n) {
+
+        const auto count = pwrite(fd, p, n, static_cast<off_t>(pos));
+
+        if (count <= 0)
+            throw std::runtime_error("unable to write file");
+
+        p += count;
+        pos += count;
+        n -= static_cast<size_type>(count);
+    }
+}
+
+random_access_file::pos_type random_access_file::size() const {
+
+    struct stat st;
+
+    if (fstat(fd, &st))
+        throw std::runtime_error("unable to size file");
+
+    return st.st_size;
+}
+
+void random_access_file::read_strided(pos_type pos, pos_type stride, size_type n, size_type count, void * dest) const {
+
+    auto p = static_cast<char *>(dest);
+
+    const auto gap = static_cast<size_type>(stride) - n;
+
+    // Reading over a wide gap costs more than the calls it saves; go run by run instead.
+    const size_type max_gap = 64 * 1024;
+
+    if (gap > max_gap || count < 2) {
+        for (size_type i = 0; i < count; i++, pos += stride, p += n)
+            if (read_at(pos, p, n) != n)
+                throw std::runtime_error("unexpected end of file");
+        return;
+    }
+
+    // Every gap is read into the same scratch, which is never looked at.
+    std::vector<char> scratch(gap);
+
+    const size_type max_runs = IOV_MAX / 2;
+
+    std::vector<iovec> iov;
+    iov.reserve(max_runs * 2);
+
+    while (count) {
+
+        const auto runs = std::min(count, max_runs);
+
+        iov.clear();
+
+        size_type expected = 0;
+
+        for (size_type i = 0; i < runs; i++) {
+
+            iov.push_back({ p + i * n, n });
+            expected += n;
+
+            // There is no gap to read past after the last run.
+            if (gap && i + 1 < runs) {
+                iov.push_back({ scratch.data(), gap });
+                expected += gap;
+            }
+        }
+
+        // Vectored reads may come up short, in which case the remainder goes run by run.
+        const auto result = preadv(fd, iov.data(), static_cast<int>(iov.size()), static_cast<off_t>(pos));
+
+        if (result < 0)
+            throw std::runtime_error("unable to read file");
+
+        if (static_cast<size_type>(result) != expected) {
+            for (size_type i = 0; i < runs; i++)
+                if (read_at(pos + i * stride, p + i * n, n) != n)
+                    throw std::runtime_error("unexpected end of file");
+        }
+
+        pos += runs * stride;
+        p += runs * n;
+        count -= runs;
+    }
+}
+
+void random_access_file::write_gathered(pos_type pos, block const * blocks, size_type count) {
+
+    const size_type max_blocks = IOV_MAX;
+
+    std::vector<iovec> iov;
+
+    while (count) {
+
+        const auto n = std::min(count, max_blocks);
+
+        iov.clear();
+
+        size_type expected = 0;
+
+        for (size_type i = 0; i < n; i++) {
+            iov.push_back({ const_cast<void *>(blocks[i].data), blocks[i].size });
+            expected += blocks[i].size;
+        }
+
+        const auto result = pwritev(fd, iov.data(), static_cast<int>(iov.size()), static_cast<off_t>(pos));
+
+        if (result < 0)
+            throw std::runtime_error("unable to write file");
+
+        // Vectored writes may come up short, in which case the remainder goes block by block.
+        if (static_cast<size_type>(result) != expected) {
+
+            auto written = static_cast<size_type>(result);
+            auto at = pos;
+
+            for (size_type i = 0; i < n; at += blocks[i].size, i++) {
+
+                const auto skip = std::min(written, blocks[i].size);
+
+                write_at(at + skip, static_cast<char const *>(blocks[i].data) + skip, blocks[i].size - skip);
+
+                written -= skip;
+            }
+        }
+
+        for (size_type i = 0; i < n; i++)
+            pos += blocks[i].size;
+
+        blocks += n;
+        count -= n;
+    }
+}
+
+#endif
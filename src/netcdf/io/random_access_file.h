@@ -0,0 +1,66 @@
+#ifndef NETCDF_RANDOM_ACCESS_FILE_H
+#define NETCDF_RANDOM_ACCESS_FILE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* An open file that is read and written by position, i.e. pread and pwrite, rather than through
+a stream with a single shared position. Positional access does not disturb any other access in
+flight, and is the basis for reading strided data, i.e. records, in a single vectored call. */
+struct random_access_file {
+
+    typedef std::size_t size_type;
+    typedef int64_t pos_type;
+
+    // One of the pieces of a gathered write.
+    struct block {
+        void const * data;
+        size_type size;
+    };
+
+    enum open_mode {
+        read_only,
+        read_write,
+        // Creates the file, or truncates it when it already exists, for read and write.
+        create
+    };
+
+    random_access_file(std::string const & path, open_mode mode = read_only);
+
+    virtual ~random_access_file();
+
+    // Reads up to n bytes at pos, returning how many were read; fewer only at the end of the file.
+    size_type read_at(pos_type pos, void * dest, size_type n) const;
+
+    /* Reads count runs of n bytes, stride bytes apart starting at pos, back to back into dest. The
+    runs are gathered with vectored reads when the gaps between them are small enough to be worth
+    reading over, otherwise they are read one at a time, as they always are on Windows, which has
+    no vectored read into arbitrary memory. */
+    void read_strided(pos_type pos, pos_type stride, size_type n, size_type count, void * dest) const;
+
+    void write_at(pos_type pos, void const * src, size_type n);
+
+    /* Writes the blocks back to back starting at pos, gathered into as few calls as will take
+    them, i.e. vectored writes, such that pieces kept apart in memory need not be copied together.
+    On Windows the blocks are written one at a time, still without being copied together. */
+    void write_gathered(pos_type pos, block const * blocks, size_type count);
+
+    pos_type size() const;
+
+private:
+
+    random_access_file(random_access_file const &) {}
+
+#ifdef _WIN32
+    void * hFile;
+#else
+    int fd;
+#endif
+};
+
+#endif //NETCDF_RANDOM_ACCESS_FILE_H
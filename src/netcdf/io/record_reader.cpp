@@ -0,0 +1,199 @@
+#include "record_reader.h"
+
+#include <stdexcept>
+
+///////////////////////////////////////////////////////////////////////////////
+
+record_reader::record_reader(netcdf & theCdf)
+    : pCdf(&theCdf)
+    , pIO(nullptr)
+    , vars()
+    , headers()
+    , shapes()
+    , slabs()
+    , unloaded()
+    , index(-1)
+    , current()
+    , ahead()
+    , ahead_pending() {
+
+    init();
+}
+
+record_reader::record_reader(netcdf & theCdf, thread_pool & io)
+    : pCdf(&theCdf)
+    , pIO(&io)
+    , vars()
+    , headers()
+    , shapes()
+    , slabs()
+    , unloaded()
+    , index(-1)
+    , current()
+    , ahead()
+    , ahead_pending() {
+
+    init();
+}
+
+record_reader::~record_reader() {
+
+    // The buffers being read into are ours, so they must outlast the read.
+    if (ahead_pending.valid())
+        ahead_pending.wait();
+}
+
+void record_reader::init() {
+
+    auto & theCdf = *pCdf;
+
+    for (auto var_it = theCdf.vars.begin(); var_it != theCdf.vars.end(); var_it++) {
+
+        if (!var_it->is_record(theCdf.dims)) continue;
+
+        auto shape = theCdf.get_shape(*var_it);
+
+        // One record, i.e. one along the record dim, and the whole of each of the others.
+        slab::index_vector start(shape.size(), 0);
+        slab::index_vector count(shape);
+
+        count[0] = 1;
+
+        vars.push_back(var_it);
+        headers.push_back(var_it->get_header());
+        headers.back().loader = var_it->loader;
+        shapes.push_back(shape);
+        slabs.push_back(slab(start, count));
+    }
+
+    unloaded.resize(vars.size());
+    current.resize(vars.size());
+    ahead.resize(vars.size());
+
+    if (pIO && theCdf.numrecs > 0)
+        read(0, ahead);
+}
+
+void record_reader::read(int64_t r, std::vector<data_buffer> & buffers) {
+
+    auto any_unloaded = false;
+
+    for (size_type i = 0; i < vars.size(); i++) {
+
+        slabs[i].start[0] = r;
+
+        unloaded[i] = !vars[i]->is_loaded();
+
+        // Loaded vars are gathered from memory there and then.
+        if (!unloaded[i]) {
+            pCdf->read_slab(vars[i], slabs[i], buffers[i]);
+            continue;
+        }
+
+        buffers[i].assign_uninitialized(vars[i]->get_type(), static_cast<data_buffer::size_type>(slabs[i].get_nelems()));
+
+        any_unloaded = true;
+    }
+
+    if (!any_unloaded) return;
+
+    // The rest are read by one task, rather than one apiece, the records being small as a rule.
+    if (pIO)
+        ahead_pending = pIO->async([this, &buffers]() { read_unloaded(buffers); });
+    else
+        read_unloaded(buffers);
+}
+
+void record_reader::read_unloaded(std::vector<data_buffer> & buffers) {
+    for (size_type i = 0; i < vars.size(); i++)
+        if (unloaded[i])
+            headers[i].loader->read_slab(headers[i], slabs[i], shapes[i], buffers[i]);
+}
+
+bool record_reader::next() {
+
+    const auto numrecs = pCdf->numrecs;
+
+    if (index + 1 >= numrecs) {
+        index = numrecs;
+        return false;
+    }
+
+    index++;
+
+    if (!pIO) {
+        read(index, current);
+        return true;
+    }
+
+    // The record was read ahead; take it, and start on the one after it in the buffers just let go.
+    if (ahead_pending.valid())
+        ahead_pending.get();
+
+    current.swap(ahead);
+
+    if (index + 1 < numrecs)
+        read(index + 1, ahead);
+
+    return true;
+}
+
+int64_t record_reader::get_index() const {
+    return index;
+}
+
+record_reader::var_iterator_vector const & record_reader::get_vars() const {
+    return vars;
+}
+
+data_buffer const & record_reader::get_data(size_type i) const {
+
+    if (index < 0 || index >= pCdf->numrecs)
+        throw std::out_of_range("no record at hand");
+
+    return current.at(i);
+}
+
+data_buffer const & record_reader::get_data(std::string const & name) const {
+
+    for (size_type i = 0; i < vars.size(); i++)
+        if (vars[i]->name == name)
+            return get_data(i);
+
+    throw std::invalid_argument("record var not found");
+}
+
+record_reader::iterator record_reader::begin() {
+    return iterator(index < 0 && next() ? this : nullptr);
+}
+
+record_reader::iterator record_reader::end() {
+    return iterator();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+record_reader::iterator::iterator(record_reader * pReader)
+    : pReader(pReader) {
+}
+
+record_reader & record_reader::iterator::operator*() const {
+    return *pReader;
+}
+
+record_reader * record_reader::iterator::operator->() const {
+    return pReader;
+}
+
+record_reader::iterator & record_reader::iterator::operator++() {
+    if (!pReader->next()) pReader = nullptr;
+    return *this;
+}
+
+bool record_reader::iterator::operator==(iterator const & other) const {
+    return pReader == other.pReader;
+}
+
+bool record_reader::iterator::operator!=(iterator const & other) const {
+    return pReader != other.pReader;
+}
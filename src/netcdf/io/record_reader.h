@@ -0,0 +1,122 @@
+#ifndef NETCDF_RECORD_READER_H
+#define NETCDF_RECORD_READER_H
+
+#pragma once
+
+#include "../netcdf.h"
+
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Walks the records of a model one at a time, i.e. along the unlimited dim, giving the slab of
+each record var for the record at hand. Only two records are held at any one time: the current
+one, and, given a pool, the next, which is read in the background, in one go, while the current
+one is worked on. The buffers are reused from one record to the next, such that memory stays
+flat however many records there are.
+
+Vars not loaded are read from where they would be loaded from, by their loaders; the slabs of
+loaded vars are gathered from memory. The vars must be left as they are while the records are
+walked.
+
+    for (auto & theRecord : record_reader(cdf, io)) {
+        auto & theData = theRecord.get_data("tas");
+        ...
+    } */
+struct record_reader {
+
+    typedef std::vector<var_vector::iterator> var_iterator_vector;
+    typedef var_iterator_vector::size_type size_type;
+
+    record_reader(netcdf & cdf);
+
+    // Reads each next record on the pool, i.e. a thread set aside for I/O, while the caller works.
+    record_reader(netcdf & cdf, thread_pool & io);
+
+    // Waits for any record still being read.
+    virtual ~record_reader();
+
+    /* Moves on to the next record, waiting for it if it is still being read, and starts on the one
+    after that. Returns false once there are no more records. */
+    bool next();
+
+    // The record at hand, counting from zero, or -1 before the first.
+    int64_t get_index() const;
+
+    // The record vars, in the order they appear within a record.
+    var_iterator_vector const & get_vars() const;
+
+    /* The record at hand of the record var, shaped as the var less its record dim, i.e. the same
+    as one record of var::get_data. */
+    data_buffer const & get_data(size_type i) const;
+    data_buffer const & get_data(std::string const & name) const;
+
+    // An input iterator over the records; each one dereferences to the reader, at that record.
+    struct iterator {
+
+        typedef std::input_iterator_tag iterator_category;
+        typedef record_reader value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef record_reader * pointer;
+        typedef record_reader & reference;
+
+        iterator(record_reader * pReader = nullptr);
+
+        record_reader & operator*() const;
+        record_reader * operator->() const;
+
+        iterator & operator++();
+
+        bool operator==(iterator const & other) const;
+        bool operator!=(iterator const & other) const;
+
+    private:
+
+        record_reader * pReader;
+    };
+
+    // Begins with the next record, i.e. the first, when the reader is fresh.
+    iterator begin();
+    iterator end();
+
+private:
+
+    record_reader(record_reader const &) {}
+
+    void init();
+
+    // Reads the record into the buffers, the vars not loaded in the background when there is a pool.
+    void read(int64_t r, std::vector<data_buffer> & buffers);
+
+    // Reads the record of the vars not loaded, i.e. from the file, touching nothing of the model.
+    void read_unloaded(std::vector<data_buffer> & buffers);
+
+    netcdf * pCdf;
+    thread_pool * pIO;
+
+    var_iterator_vector vars;
+
+    // What the loaders need of each var, such that they need not touch the model.
+    std::vector<var> headers;
+    std::vector<slab::index_vector> shapes;
+
+    // The slab of one record of each var, whose start along the record dim is moved along.
+    std::vector<slab> slabs;
+
+    // Which of the vars were not loaded as of the record being read, and are read by their loaders.
+    std::vector<char> unloaded;
+
+    int64_t index;
+
+    std::vector<data_buffer> current;
+    std::vector<data_buffer> ahead;
+
+    std::future<void> ahead_pending;
+};
+
+#endif //NETCDF_RECORD_READER_H
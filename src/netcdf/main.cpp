@@ -1,72 +1,1239 @@
-
-#include "netcdf.h"
-#include "io/cdf_reader.h"
-#include "io/cdf_writer.h"
-#include "io/network_byte_order.h"
-
-#include <fstream>
-#include <cassert>
-
-int main(int argc, char* argv[]) {
-
-    {
-        assert(!is_big_endian());
-        assert(is_little_endian());
-    }
-
-    {
-        attributable & aVar = var();
-
-        aVar.add_attr<byte_vector>("some_bytes", { static_cast<uint8_t>(1), static_cast<uint8_t>(2), static_cast<uint8_t>(3), static_cast<uint8_t>(4), static_cast<uint8_t>(5) });
-        aVar.add_attr<short_vector>("some_shorts", { static_cast<int16_t>(2), static_cast<int16_t>(3), static_cast<int16_t>(4), static_cast<int16_t>(5) });
-        aVar.add_attr<int_vector>("some_ints", { static_cast<int32_t>(3), static_cast<int32_t>(4), static_cast<int32_t>(5) });
-        aVar.add_attr<float_vector>("some_floats", { static_cast<float_t>(4), static_cast<float_t>(5) });
-        aVar.add_attr<double_vector>("some_doubles", { static_cast<double_t>(5) });
-        aVar.add_text_attr("some_text", "the text");
-
-        assert(aVar.attrs.size() == 6);
-
-        assert(aVar.attrs[0].get_type() == nc_byte);
-        assert(aVar.attrs[1].get_type() == nc_short);
-        assert(aVar.attrs[2].get_type() == nc_int);
-        assert(aVar.attrs[3].get_type() == nc_float);
-        assert(aVar.attrs[4].get_type() == nc_double);
-        assert(aVar.attrs[5].get_type() == nc_char);
-
-        assert(aVar.attrs[0].values.size() == 5);
-        assert(aVar.attrs[1].values.size() == 4);
-        assert(aVar.attrs[2].values.size() == 3);
-        assert(aVar.attrs[3].values.size() == 2);
-        assert(aVar.attrs[4].values.size() == 1);
-        assert(aVar.attrs[5].values.size() == 1);
-
-        assert(aVar.attrs[0].values.front().primitive.b == 1);
-        assert(aVar.attrs[1].values.front().primitive.s == 2);
-        assert(aVar.attrs[2].values.front().primitive.i == 3);
-        assert(aVar.attrs[3].values.front().primitive.f == 4);
-        assert(aVar.attrs[4].values.front().primitive.d == 5);
-        assert(aVar.attrs[5].values.front().text == "the text");
-    }
-
-    {
-        auto & cdf = netcdf{};
-
-        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
-
-        cdf_reader(&ifs, true) >> cdf;
-
-        std::ofstream ofs("Data/testing.nc", std::ios::binary);
-
-        cdf_writer(&ofs, true) << cdf;
-    }
-
-    {
-        auto & cdf = netcdf{};
-
-        std::ofstream ofs("Data/testing2.nc", std::ios::binary);
-
-        cdf_writer(&ofs, false) << cdf;
-    }
-
-    return 0;
-}
+
+#include "netcdf.h"
+#include "io/cdf_reader.h"
+#include "io/cdf_writer.h"
+#include "io/cdf_appender.h"
+#include "io/record_reader.h"
+#include "io/network_byte_order.h"
+#include "parts/array_view.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cassert>
+
+// Reads from memory, but cannot seek, the same as a pipe.
+struct unseekable_buf : std::streambuf {
+    unseekable_buf(std::string & text) {
+        setg(&text[0], &text[0], &text[0] + text.size());
+    }
+};
+
+int main(int argc, char* argv[]) {
+
+    // The C++ types map to nc_types, and back again, at compile time.
+    static_assert(get_type_for<int16_t>() == nc_short, "int16_t is nc_short");
+    static_assert(get_type_for<double>() == nc_double, "double is nc_double");
+    static_assert(get_type_for<char>() == nc_absent, "char is text, i.e. nc_char, apart from the primitives");
+    static_assert(nc_type_traits<nc_int64>::size == 8 && nc_type_traits<nc_int64>::needs_swap, "nc_int64 is eight bytes");
+
+    {
+        assert(!is_big_endian());
+        assert(is_little_endian());
+    }
+
+    {
+        // Every type wider than a byte is byte-swapped, the floating point types as much as the integers.
+        assert(is_endian_type(nc_float) && is_endian_type(nc_double) && is_endian_type(nc_short));
+        assert(!is_endian_type(nc_byte) && !is_endian_type(nc_char) && !is_endian_type(nc_ubyte));
+
+        assert(is_primitive_type(nc_double) && !is_primitive_type(nc_char) && !is_primitive_type(nc_absent));
+    }
+
+    {
+        const auto engine = get_swap_engine();
+
+        std::vector<uint8_t> bytes(1027 + 8);
+
+        for (std::size_t i = 0; i < bytes.size(); i++)
+            bytes[i] = static_cast<uint8_t>(i * 7 + 3);
+
+        // Every engine the CPU has reverses the same as the portable one, whatever the length, or alignment.
+        for (std::size_t width : { 2, 4, 8 }) {
+            for (std::size_t offset = 0; offset < 3; offset++) {
+                for (std::size_t nelems : { 0, 1, 3, 7, 15, 17, 31, 33, 63, 65, 127 }) {
+
+                    auto src = bytes.data() + offset;
+
+                    std::vector<uint8_t> expected(nelems * width + 1), actual(nelems * width + 1);
+
+                    set_swap_engine(swap_portable);
+                    swap_endian_array(expected.data() + 1, src, width, nelems);
+
+                    for (auto e : { swap_ssse3, swap_avx2 }) {
+
+                        if (!set_swap_engine(e)) continue;
+
+                        std::fill(actual.begin(), actual.end(), 0);
+                        swap_endian_array(actual.data() + 1, src, width, nelems);
+
+                        assert(actual == expected);
+                    }
+                }
+            }
+        }
+
+        set_swap_engine(engine);
+
+        // Floats and doubles go there and back again, bit for bit.
+        std::vector<float> floats({ 1.5f, -0.0f, 3.25e-30f, 1e30f, 7.0f });
+        std::vector<double> doubles({ 1.5, -0.0, 3.25e-300, 1e300, 7.0 });
+
+        auto f = floats;
+        auto d = doubles;
+
+        swap_endian_array(f.data(), sizeof(float), f.size());
+        swap_endian_array(d.data(), sizeof(double), d.size());
+
+        assert(f[0] != floats[0] && d[0] != doubles[0]);
+
+        swap_endian_array(f.data(), sizeof(float), f.size());
+        swap_endian_array(d.data(), sizeof(double), d.size());
+
+        assert(!memcmp(f.data(), floats.data(), f.size() * sizeof(float)));
+        assert(!memcmp(d.data(), doubles.data(), d.size() * sizeof(double)));
+    }
+
+    {
+        attributable & aVar = var();
+
+        aVar.add_attr<byte_vector>("some_bytes", { static_cast<uint8_t>(1), static_cast<uint8_t>(2), static_cast<uint8_t>(3), static_cast<uint8_t>(4), static_cast<uint8_t>(5) });
+        aVar.add_attr<short_vector>("some_shorts", { static_cast<int16_t>(2), static_cast<int16_t>(3), static_cast<int16_t>(4), static_cast<int16_t>(5) });
+        aVar.add_attr<int_vector>("some_ints", { static_cast<int32_t>(3), static_cast<int32_t>(4), static_cast<int32_t>(5) });
+        aVar.add_attr<float_vector>("some_floats", { static_cast<float_t>(4), static_cast<float_t>(5) });
+        aVar.add_attr<double_vector>("some_doubles", { static_cast<double_t>(5) });
+        aVar.add_text_attr("some_text", "the text");
+
+        assert(aVar.attrs.size() == 6);
+
+        assert(aVar.attrs[0].get_type() == nc_byte);
+        assert(aVar.attrs[1].get_type() == nc_short);
+        assert(aVar.attrs[2].get_type() == nc_int);
+        assert(aVar.attrs[3].get_type() == nc_float);
+        assert(aVar.attrs[4].get_type() == nc_double);
+        assert(aVar.attrs[5].get_type() == nc_char);
+
+        assert(aVar.attrs[0].values.size() == 5);
+        assert(aVar.attrs[1].values.size() == 4);
+        assert(aVar.attrs[2].values.size() == 3);
+        assert(aVar.attrs[3].values.size() == 2);
+        assert(aVar.attrs[4].values.size() == 1);
+        assert(aVar.attrs[5].values.size() == 1);
+
+        assert(aVar.attrs[0].values.front().primitive.b == 1);
+        assert(aVar.attrs[1].values.front().primitive.s == 2);
+        assert(aVar.attrs[2].values.front().primitive.i == 3);
+        assert(aVar.attrs[3].values.front().primitive.f == 4);
+        assert(aVar.attrs[4].values.front().primitive.d == 5);
+        assert(aVar.attrs[5].values.front().text == "the text");
+    }
+
+    {
+        auto & aVar = var();
+
+        aVar.set_values<short_vector>({ static_cast<int16_t>(1), static_cast<int16_t>(2), static_cast<int16_t>(3) });
+
+        assert(aVar.get_type() == nc_short);
+        assert(aVar.data.size() == 3);
+        assert(aVar.data.size_in_bytes() == 3 * sizeof(int16_t));
+        assert(reinterpret_cast<uintptr_t>(aVar.data.data()) % data_buffer::alignment == 0);
+
+        assert(aVar.data.data_as<int16_t>()[0] == 1);
+        assert(aVar.data.at<int16_t>(2) == 3);
+        assert(aVar.data.get_values<short_vector>() == short_vector({ 1, 2, 3 }));
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true) >> cdf;
+
+        std::ofstream ofs("Data/testing.nc", std::ios::binary);
+
+        cdf_writer(&ofs, true) << cdf;
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        cdf_reader(std::make_shared<mapped_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true) >> cdf;
+
+        // Variable data is viewed straight from the mapping until asked to be copied; see data_buffer::materialize.
+        for (auto & aVar : cdf.vars)
+            assert(aVar.data.is_view());
+
+        std::ofstream ofs("Data/testing3.nc", std::ios::binary);
+
+        cdf_writer(&ofs, true) << cdf;
+    }
+
+    {
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        const std::vector<char> bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+        // Read from memory in place, the same as from a mapping, and written back out the same.
+        auto & cdf = netcdf{};
+
+        cdf_reader(bytes.data(), bytes.size(), true) >> cdf;
+
+        for (auto & aVar : cdf.vars)
+            assert(aVar.data.is_view());
+
+        auto & mapped = netcdf{};
+
+        cdf_reader(std::make_shared<mapped_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true) >> mapped;
+
+        std::ostringstream from_memory, from_mapping;
+
+        cdf_writer(&from_memory, true) << cdf;
+        cdf_writer(&from_mapping, true) << mapped;
+
+        assert(from_memory.str() == from_mapping.str());
+
+        // Short of reversing, i.e. written in host byte order, the data is the caller's memory itself.
+        std::ostringstream unreversed;
+
+        cdf_writer(&unreversed, false) << cdf;
+
+        const auto text = unreversed.str();
+
+        auto & raw = netcdf{};
+
+        cdf_reader(text.data(), text.size(), false) >> raw;
+
+        auto const & theData = raw.get_var("tas")->data;
+        auto p = static_cast<char const *>(theData.data());
+
+        assert(p >= text.data() && p + theData.size_in_bytes() <= text.data() + text.size());
+    }
+
+    {
+        auto & mapped = netcdf{};
+
+        cdf_reader(std::make_shared<mapped_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true) >> mapped;
+
+        auto & streamed = netcdf{};
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true) >> streamed;
+
+        // Written either way round, the views go out as they are, or reversed, and are left views.
+        std::ostringstream mapped_out, streamed_out;
+
+        cdf_writer(&mapped_out, false) << mapped;
+        cdf_writer(&streamed_out, false) << streamed;
+
+        assert(mapped_out.str() == streamed_out.str());
+
+        for (auto & aVar : mapped.vars)
+            assert(aVar.data.is_view());
+
+        // Neither const access, nor mutable, copies a view behind the caller's back; either throws.
+        auto var_it = mapped.get_var("tas");
+        auto const & theVar = *var_it;
+
+        assert(!theVar.get_data().is_host_order());
+
+        bool threw = false;
+
+        try {
+            theVar.get_data().data();
+        }
+        catch (std::logic_error const &) {
+            threw = true;
+        }
+
+        assert(threw);
+
+        threw = false;
+
+        try {
+            var_it->get_data().data();
+        }
+        catch (std::logic_error const &) {
+            threw = true;
+        }
+
+        assert(threw && var_it->data.is_view());
+
+        // Copied when, and only when, asked.
+        var_it->data.materialize();
+
+        auto const & theData = var_it->data;
+        auto const & expected = streamed.get_var("tas")->data;
+
+        assert(!theData.is_view() && theData.is_host_order());
+        assert(!memcmp(theData.data(), expected.data(), expected.size_in_bytes()));
+
+        // A var not loaded has no data to be had as it is.
+        auto & header = netcdf{};
+
+        cdf_reader(std::make_shared<random_access_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true).read_header(header);
+
+        threw = false;
+
+        try {
+            static_cast<var const &>(*header.get_var("tas")).get_data();
+        }
+        catch (std::logic_error const &) {
+            threw = true;
+        }
+
+        assert(threw);
+    }
+    {
+        auto & cdf = netcdf{};
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true).read_header(cdf);
+
+        for (auto & aVar : cdf.vars)
+            assert(!aVar.is_loaded());
+
+        // Only the one var is loaded, on first access, and may be released again.
+        auto var_it = cdf.get_var("tas");
+
+        assert(!var_it->get_data().empty());
+        assert(var_it->is_loaded());
+
+        var_it->unload();
+
+        assert(!var_it->is_loaded());
+        assert(var_it->data.empty());
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true).read_header(cdf);
+
+        auto var_it = cdf.get_var("tas");
+
+        auto shape = cdf.get_shape(*var_it);
+
+        // Every other lon, of a few lats, read straight from the file.
+        slab aSlab({ 0, 2, 0 }, { 1, 3, shape[2] / 2 }, { 1, 1, 2 });
+
+        data_buffer fromFile;
+
+        cdf.read_slab(var_it, aSlab, fromFile);
+
+        assert(!var_it->is_loaded());
+        assert(fromFile.size() == static_cast<data_buffer::size_type>(aSlab.get_nelems()));
+
+        // The same slab gathered from memory is the same.
+        var_it->load();
+
+        data_buffer fromMemory;
+
+        cdf.read_slab(var_it, aSlab, fromMemory);
+
+        assert(!memcmp(fromFile.data(), fromMemory.data(), fromFile.size_in_bytes()));
+        assert(fromFile.at<float>(1) == var_it->data.at<float>(2 * shape[2] + 2));
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        cdf_reader(std::make_shared<random_access_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true).read_header(cdf);
+
+        // Every record of a record var is gathered, from wherever it falls among the records.
+        auto var_it = cdf.get_var("tas");
+
+        assert(var_it->is_record(cdf.dims));
+        assert(var_it->get_data().size() == var_it->get_nelems(cdf.dims) * cdf.numrecs);
+
+        std::ofstream ofs("Data/testing4.nc", std::ios::binary);
+
+        cdf_writer(&ofs, true) << cdf;
+    }
+
+    {
+        auto & cdf = netcdf{};
+        auto & loaded = netcdf{};
+
+        cdf_reader(std::make_shared<random_access_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true).read_header(cdf);
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true) >> loaded;
+
+        // A thread set aside for I/O loads the vars, and a slab, while the caller gets on meanwhile.
+        thread_pool io(1);
+
+        auto tas = cdf.prefetch_var("tas", io);
+        auto lat = cdf.prefetch_var("lat", io);
+
+        slab aSlab({ 0, 2, 0 }, { 1, 3, 8 });
+
+        data_buffer fromFile;
+
+        auto slab_ready = cdf.read_slab_async("tas", aSlab, fromFile, io);
+
+        assert(cdf.get_var("tas")->is_prefetching() && !cdf.get_var("tas")->is_loaded());
+
+        lat.wait();
+
+        auto var_it = cdf.get_var("lat");
+
+        assert(!memcmp(var_it->get_data().data(), loaded.get_var("lat")->data.data(), var_it->data.size_in_bytes()));
+        assert(var_it->is_loaded() && !var_it->is_prefetching());
+
+        // Asked for before the prefetch is done, the data is waited for.
+        var_it = cdf.get_var("tas");
+
+        assert(var_it->get_data().size() == loaded.get_var("tas")->data.size());
+        assert(!memcmp(var_it->data.data(), loaded.get_var("tas")->data.data(), var_it->data.size_in_bytes()));
+        assert(tas.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+
+        data_buffer fromMemory;
+
+        slab_ready.get();
+
+        loaded.read_slab("tas", aSlab, fromMemory);
+
+        assert(!memcmp(fromFile.data(), fromMemory.data(), fromFile.size_in_bytes()));
+    }
+
+    {
+        cdf_appender appender(std::make_shared<random_access_file>("Data/testing4.nc", random_access_file::read_write), true);
+
+        const auto numrecs = appender.get_cdf().numrecs;
+
+        // Append another record of tas, the same as the first; the other record vars are zeroed.
+        var_vector records;
+
+        for (auto & aVar : appender.get_cdf().vars)
+            if (aVar.name == "tas") records.push_back(aVar);
+
+        // Not loaded, the var holds no records to speak of, which is an error rather than nothing to append.
+        auto threw = false;
+
+        try { appender.append_records(records); }
+        catch (std::invalid_argument const &) { threw = true; }
+
+        assert(threw && appender.get_cdf().numrecs == numrecs);
+
+        records.front().load();
+
+        assert(appender.append_records(records) == 1);
+        assert(appender.get_cdf().numrecs == numrecs + 1);
+    }
+
+    {
+        auto & cdf = netcdf{};
+        auto & loaded = netcdf{};
+
+        cdf_reader(std::make_shared<random_access_file>("Data/testing4.nc"), true).read_header(cdf);
+
+        std::ifstream ifs("Data/testing4.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true) >> loaded;
+
+        assert(cdf.numrecs > 1);
+
+        // Walked a record at a time, the next read meanwhile, each record is that of the var as a whole.
+        thread_pool io(1);
+
+        int64_t r = 0;
+
+        for (auto & theRecord : record_reader(cdf, io)) {
+
+            assert(theRecord.get_index() == r);
+
+            for (record_reader::size_type i = 0; i < theRecord.get_vars().size(); i++) {
+
+                auto & theData = theRecord.get_data(i);
+                auto & whole = loaded.get_var(theRecord.get_vars()[i]->name)->data;
+
+                assert(theData.size() * cdf.numrecs == whole.size());
+                assert(!memcmp(theData.data(), static_cast<char const *>(whole.data()) + r * theData.size_in_bytes(), theData.size_in_bytes()));
+            }
+
+            r++;
+        }
+
+        assert(r == cdf.numrecs);
+
+        // Likewise without a pool, and from memory.
+        record_reader reader(loaded);
+
+        auto & tas = loaded.get_var("tas")->data;
+
+        while (reader.next()) {
+            auto & theData = reader.get_data("tas");
+            assert(!memcmp(theData.data(), static_cast<char const *>(tas.data()) + reader.get_index() * theData.size_in_bytes(), theData.size_in_bytes()));
+        }
+
+        assert(reader.get_index() == loaded.numrecs);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true).read_header(cdf);
+
+        // The records are streamed from a copy, which is all that need be in memory at any one time.
+        auto source = *cdf.get_var("tas");
+
+        source.load();
+
+        cdf.get_var("tas")->data.clear();
+
+        std::ofstream ofs("Data/testing5.nc", std::ios::binary);
+
+        cdf_writer writer(&ofs, true);
+
+        writer.begin_records(cdf);
+
+        assert(cdf.numrecs == 0);
+
+        writer.write_record(var_vector({ source }));
+        writer.write_record(var_vector({ source }));
+
+        writer.end_records();
+
+        assert(cdf.numrecs == 2);
+    }
+
+    {
+        std::ifstream ifs("Data/testing5.nc", std::ios::binary);
+
+        std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+        // As though streamed through a pipe, i.e. numrecs left STREAMING, and read back through one.
+        std::fill_n(bytes.begin() + 4, bytes[3] == x64_data ? 8 : 4, '\xff');
+
+        unseekable_buf buf(bytes);
+        std::istream is(&buf);
+
+        auto & cdf = netcdf{};
+
+        cdf_reader(&is, true) >> cdf;
+
+        assert(cdf.numrecs == 2);
+
+        auto var_it = cdf.get_var("tas");
+
+        assert(var_it->data.size() == 2 * var_it->get_nelems(cdf.dims));
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        // CDF-5 carries 64-bit sizes, and the unsigned and 64-bit types, through and through.
+        cdf.magic.version = x64_data;
+
+        auto dim_it = cdf.add_dim("x", 3);
+
+        std::string name = "big";
+
+        auto var_it = cdf.add_var(name, nc_int64);
+
+        cdf.redim_var(var_it, netcdf::dim_vector_iterator_vector({ dim_it }));
+
+        var_it->set_values(std::vector<int64_t>({ 1LL << 40, -1, 3 }));
+
+        {
+            std::ofstream ofs("Data/testing6.nc", std::ios::binary);
+
+            cdf_writer(&ofs, true) << cdf;
+        }
+
+        auto & back = netcdf{};
+
+        std::ifstream ifs("Data/testing6.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true) >> back;
+
+        assert(back.magic.is_x64_data());
+        assert(back.get_var("big")->get_type() == nc_int64);
+        assert(back.get_var("big")->data.at<int64_t>(0) == 1LL << 40);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        cdf.add_dim("y", 2);
+        cdf.add_dim("x", 3);
+
+        auto var_it = cdf.add_var("grid", nc_float);
+
+        cdf.redim_var(var_it, netcdf::dim_vector_iterator_vector({ cdf.dims.begin(), cdf.dims.begin() + 1 }));
+
+        var_it->set_values(std::vector<float>({ 0, 1, 2, 3, 4, 5 }));
+
+        // Views, however sliced or transposed, refer to the var's own elements.
+        array_view<float> grid(*var_it, cdf.dims);
+
+        assert(grid.rank() == 2 && grid.extent(0) == 2 && grid.extent(1) == 3);
+        assert(grid.data() == var_it->data.data_as<float>());
+        assert(grid(1, 2) == 5);
+
+        auto transposed = grid.transposed();
+
+        assert(!transposed.is_contiguous());
+        assert(transposed.extent(0) == 3 && transposed(2, 1) == 5);
+
+        auto row = grid.slice(0, 1);
+
+        assert(row.rank() == 1 && row(0) == 3);
+
+        auto corner = grid.subview({ 0, 1 }, { 2, 2 });
+
+        assert(corner(1, 1) == 5);
+
+        corner(0, 0) = 10;
+
+        assert(var_it->data.at<float>(1) == 10);
+
+        float sum = 0;
+
+        array_view<float const>(grid).for_each([&](float const & x) { sum += x; });
+
+        assert(sum == 24);
+
+        // Reordered, the dims and the data go along together, and it reads the same transposed.
+        cdf.reorder_var(var_it, netcdf::dim_vector_iterator_vector({ cdf.dims.begin() + 1, cdf.dims.begin() }));
+
+        assert(var_it->dimids.size() == 2 && var_it->dimids[0] == 1 && var_it->dimids[1] == 0);
+        assert(var_it->data.at<float>(1) == 3 && var_it->data.at<float>(2) == 10 && var_it->data.at<float>(5) == 5);
+
+        array_view<float const> reordered(*var_it, cdf.dims);
+
+        assert(reordered.is_contiguous() && reordered(2, 1) == 5 && reordered(1, 0) == 10);
+
+        // Data short of what the dims call for is refused rather than viewed past its end.
+        var_it->set_values(std::vector<float>({ 0, 1, 2, 3, 4 }));
+
+        auto refused = false;
+
+        try { array_view<float>(*var_it, cdf.dims); }
+        catch (std::invalid_argument const &) { refused = true; }
+
+        assert(refused);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        cdf_reader(std::make_shared<random_access_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true).read_header(cdf);
+
+        // A const view cannot load the var, so one not loaded is refused.
+        auto refused = false;
+
+        try { array_view<float const>(static_cast<var const &>(*cdf.get_var("tas")), cdf.dims); }
+        catch (std::invalid_argument const &) { refused = true; }
+
+        assert(refused);
+
+        // Nor is a record var of part of a record.
+        auto & theData = cdf.get_var("tas")->get_data();
+
+        theData.assign(nc_float, theData.size() - 1);
+
+        refused = false;
+
+        try { array_view<float>(*cdf.get_var("tas"), cdf.dims); }
+        catch (std::invalid_argument const &) { refused = true; }
+
+        assert(refused);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        thread_pool pool(4);
+
+        // Each var, or chunk of a large var, is read by position on whichever thread it falls to.
+        cdf_reader(std::make_shared<random_access_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true).read_cdf(cdf, pool);
+
+        for (auto & aVar : cdf.vars)
+            assert(aVar.data.size() == aVar.get_nelems(cdf.dims) * (aVar.is_record(cdf.dims) ? cdf.numrecs : 1));
+    }
+
+    {
+        thread_pool pool(2);
+
+        std::promise<void> release;
+        auto released = release.get_future().share();
+
+        // One worker held up, and another task failing, neither of which the batch has anything to do with.
+        auto held = pool.async([=]() { released.wait(); });
+        auto failed = pool.async([]() { throw std::runtime_error("unrelated"); });
+
+        std::vector<int> results(8, 0);
+
+        {
+            thread_pool::batch tasks(pool);
+
+            for (auto i = 0; i < 8; i++)
+                tasks.submit([&results, i]() { results[i] = i + 1; });
+
+            tasks.wait();
+        }
+
+        assert(results == std::vector<int>({ 1, 2, 3, 4, 5, 6, 7, 8 }));
+        assert(held.wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+
+        // The loads of a file go as a batch of their own, likewise.
+        auto & cdf = netcdf{};
+
+        cdf_reader(std::make_shared<random_access_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true).read_cdf(cdf, pool);
+
+        assert(cdf.get_var("tas")->data.size() == cdf.get_var("tas")->get_nelems(cdf.dims) * cdf.numrecs);
+
+        release.set_value();
+
+        bool threw = false;
+
+        try {
+            failed.get();
+        }
+        catch (std::runtime_error const &) {
+            threw = true;
+        }
+
+        assert(threw);
+
+        // Whatever a batch throws goes to its own wait, and no further.
+        thread_pool::batch failing(pool);
+
+        failing.submit([]() { throw std::out_of_range("batched"); });
+        failing.submit([]() {});
+
+        threw = false;
+
+        try {
+            failing.wait();
+        }
+        catch (std::out_of_range const &) {
+            threw = true;
+        }
+
+        assert(threw);
+
+        pool.wait();
+    }
+
+    {
+        thread_pool pool(1);
+
+        // Waited for from a task of the same pool, the batch is run by the one waiting rather than deadlocking.
+        auto nested = pool.async([&pool]() {
+
+            int count = 0;
+
+            thread_pool::batch tasks(pool);
+
+            for (auto i = 0; i < 4; i++)
+                tasks.submit([&count]() { count++; });
+
+            tasks.wait();
+
+            return count;
+        });
+
+        assert(nested.get() == 4);
+    }
+
+    {
+        // Short of a pool, a batch runs each task there and then, on the caller's thread, as the serial writes do.
+        thread_pool::batch tasks(nullptr);
+
+        std::thread::id ran_on;
+
+        tasks.submit([&ran_on]() { ran_on = std::this_thread::get_id(); });
+
+        assert(ran_on == std::this_thread::get_id());
+
+        bool threw = false;
+
+        try {
+            tasks.submit([]() { throw std::runtime_error("inline"); });
+        }
+        catch (std::runtime_error const &) {
+            threw = true;
+        }
+
+        assert(threw);
+
+        tasks.wait();
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true) >> cdf;
+
+        {
+            std::ofstream ofs("Data/testing7.nc", std::ios::binary);
+
+            cdf_writer(&ofs, true) << cdf;
+        }
+
+        thread_pool pool(4);
+
+        // The data is written by position, to the offsets the header gives, on whichever thread it falls to.
+        cdf_writer(std::make_shared<random_access_file>("Data/testing8.nc", random_access_file::create), true).write_cdf(cdf, pool);
+
+        std::ifstream a("Data/testing7.nc", std::ios::binary);
+        std::ifstream b("Data/testing8.nc", std::ios::binary);
+
+        assert(std::equal(std::istreambuf_iterator<char>(a), std::istreambuf_iterator<char>(),
+            std::istreambuf_iterator<char>(b)));
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        cdf.add_dim("x", 4 * 1024 * 1024);
+
+        auto var_it = cdf.add_var("big", nc_float);
+
+        cdf.redim_var(var_it, netcdf::dim_vector_iterator_vector({ cdf.dims.begin() }));
+
+        std::vector<float> values(4 * 1024 * 1024);
+
+        for (std::size_t i = 0; i < values.size(); i++)
+            values[i] = static_cast<float>(i);
+
+        var_it->set_values(values);
+
+        {
+            std::ofstream ofs("Data/testing10.nc", std::ios::binary);
+
+            cdf_writer(&ofs, true) << cdf;
+        }
+
+        // Viewed from the mapping, still to be reversed, the var is put in host order once, not by each chunk.
+        auto & mapped = netcdf{};
+
+        cdf_reader(std::make_shared<mapped_file>("Data/testing10.nc"), true) >> mapped;
+
+        assert(mapped.get_var("big")->data.is_view());
+
+        thread_pool pool(4);
+
+        cdf_writer(std::make_shared<random_access_file>("Data/testing11.nc", random_access_file::create), true).write_cdf(mapped, pool);
+
+        std::ifstream a("Data/testing10.nc", std::ios::binary);
+        std::ifstream b("Data/testing11.nc", std::ios::binary);
+
+        assert(std::equal(std::istreambuf_iterator<char>(a), std::istreambuf_iterator<char>(),
+            std::istreambuf_iterator<char>(b)));
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        cdf.add_dim("x", 1000);
+
+        const auto x = netcdf::dim_vector_iterator_vector({ cdf.dims.begin() });
+
+        cdf.redim_var(cdf.add_var("a", nc_float), x);
+        cdf.get_var("a")->set_values(std::vector<float>(1000, 1.5f));
+
+        // Given no data at all, the var is written as zeros, as many as its dims call for, by either writer.
+        cdf.redim_var(cdf.add_var("b", nc_float), x);
+
+        std::ostringstream oss;
+
+        cdf_writer(&oss, true) << cdf;
+
+        thread_pool pool(4);
+
+        cdf_writer(std::make_shared<random_access_file>("Data/testing12.nc", random_access_file::create), true).write_cdf(cdf, pool);
+
+        const auto text = oss.str();
+
+        std::ifstream ifs("Data/testing12.nc", std::ios::binary);
+
+        const std::string pooled((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+        assert(text.size() == static_cast<std::size_t>(cdf.get_var("b")->offset.begin + cdf.get_var("b")->vsize));
+        assert(pooled == text);
+
+        auto & back = netcdf{};
+
+        cdf_reader(text.data(), text.size(), true) >> back;
+
+        // Read in place, the data is viewed in file byte order until asked to be put in host order.
+        back.get_var("b")->data.materialize();
+
+        auto const & theData = back.get_var("b")->data;
+
+        assert(theData.size() == 1000 && theData.at<float>(0) == 0 && theData.at<float>(999) == 0);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        cdf.add_dim("t", 0);
+        cdf.add_dim("x", 3);
+        cdf.add_dim("y", 5);
+
+        const auto t = cdf.dims.begin(), x = cdf.dims.begin() + 1, y = cdf.dims.begin() + 2;
+
+        // Bytes, shorts and text, none of them a multiple of four bytes long, fixed and per record.
+        cdf.redim_var(cdf.add_var("b", nc_byte), { x });
+        cdf.redim_var(cdf.add_var("s", nc_short), { y });
+        cdf.redim_var(cdf.add_var("c", nc_char), { y });
+        cdf.redim_var(cdf.add_var("rb", nc_byte), { t, x });
+        cdf.redim_var(cdf.add_var("rs", nc_short), { t, x });
+
+        cdf.get_var("b")->set_values(byte_vector({ 1, 2, 3 }));
+        cdf.get_var("s")->set_values(short_vector({ 0x0102, -2, 3, 4, 5 }));
+        cdf.get_var("rb")->set_values(byte_vector({ 10, 11, 12, 13, 14, 15 }));
+        cdf.get_var("rs")->set_values(short_vector({ 0x0a0b, 21, 22, 23, 24, -25 }));
+
+        auto & text = cdf.get_var("c")->data;
+
+        text.assign(nc_char, 5);
+        memcpy(text.data(), "hello", 5);
+
+        cdf.numrecs = 2;
+
+        // The file as the format lays it out, element by element, big-endian, each part padded to four bytes with zeros.
+        std::string expected;
+
+        const auto put_int = [&](int32_t v) {
+            for (auto shift : { 24, 16, 8, 0 })
+                expected.push_back(static_cast<char>((v >> shift) & 0xff));
+        };
+
+        const auto put_short = [&](int16_t v) {
+            expected.push_back(static_cast<char>((v >> 8) & 0xff));
+            expected.push_back(static_cast<char>(v & 0xff));
+        };
+
+        const auto pad = [&]() {
+            while (expected.size() % 4) expected.push_back('\0');
+        };
+
+        const auto put_name = [&](std::string const & name) {
+            put_int(static_cast<int32_t>(name.size()));
+            expected += name;
+            pad();
+        };
+
+        const auto put_var = [&](std::string const & name, std::vector<int32_t> const & dimids, int32_t type, int32_t vsize, int32_t begin) {
+            put_name(name);
+            put_int(static_cast<int32_t>(dimids.size()));
+            for (auto id : dimids) put_int(id);
+            put_int(0); put_int(0);
+            put_int(type); put_int(vsize); put_int(begin);
+        };
+
+        expected += std::string("CDF\x01", 4);
+        put_int(2);
+
+        put_int(nc_dimension); put_int(3);
+        put_name("t"); put_int(0);
+        put_name("x"); put_int(3);
+        put_name("y"); put_int(5);
+
+        put_int(0); put_int(0);
+
+        // The header runs to 256 bytes; the fixed vars follow, then records of 4 + 8 bytes.
+        put_int(nc_variable); put_int(5);
+        put_var("b", { 1 }, nc_byte, 4, 256);
+        put_var("s", { 2 }, nc_short, 12, 260);
+        put_var("c", { 2 }, nc_char, 8, 272);
+        put_var("rb", { 0, 1 }, nc_byte, 4, 280);
+        put_var("rs", { 0, 1 }, nc_short, 8, 284);
+
+        assert(expected.size() == 256);
+
+        for (auto v : { 1, 2, 3 }) expected.push_back(static_cast<char>(v));
+        pad();
+
+        for (auto v : { 0x0102, -2, 3, 4, 5 }) put_short(static_cast<int16_t>(v));
+        pad();
+
+        expected += "hello";
+        pad();
+
+        for (auto r = 0; r < 2; r++) {
+            for (auto i = 0; i < 3; i++) expected.push_back(static_cast<char>(10 + r * 3 + i));
+            pad();
+            for (auto i = 0; i < 3; i++) put_short(short_vector({ 0x0a0b, 21, 22, 23, 24, -25 })[r * 3 + i]);
+            pad();
+        }
+
+        std::ostringstream oss;
+
+        cdf_writer(&oss, true) << cdf;
+
+        assert(oss.str() == expected);
+
+        // The file writer, whether serial or pooled, lays out the same bytes, header and padding alike.
+        thread_pool pool(4);
+
+        {
+            cdf_writer(std::make_shared<random_access_file>("Data/testing13.nc", random_access_file::create), true) << cdf;
+        }
+
+        cdf_writer(std::make_shared<random_access_file>("Data/testing14.nc", random_access_file::create), true).write_cdf(cdf, pool);
+
+        for (auto path : { "Data/testing13.nc", "Data/testing14.nc" }) {
+
+            std::ifstream ifs(path, std::ios::binary);
+
+            const std::string written((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+            assert(written == expected);
+        }
+
+        // And back again, the same values.
+        auto & back = netcdf{};
+
+        cdf_reader(std::make_shared<random_access_file>("Data/testing13.nc"), true) >> back;
+
+        assert(back.get_var("s")->data.get_values<short_vector>() == short_vector({ 0x0102, -2, 3, 4, 5 }));
+        assert(back.get_var("rs")->data.get_values<short_vector>() == short_vector({ 0x0a0b, 21, 22, 23, 24, -25 }));
+        assert(!memcmp(back.get_var("c")->data.data(), "hello", 5));
+    }
+
+    {
+        thread_pool pool(4);
+
+        auto & cdf = netcdf{};
+
+        cdf_reader(std::make_shared<random_access_file>("Data/sresa1b_ncar_ccsm3-example.nc"), true).read_header(cdf);
+
+        auto var_it = cdf.get_var("tas");
+
+        // The record dim stays first; the rest are swapped as the var goes from file to file.
+        const auto dims_of = [](netcdf & x, var const & aVar) {
+            return netcdf::dim_vector_iterator_vector({ x.dims.begin() + aVar.dimids[0],
+                x.dims.begin() + aVar.dimids[2], x.dims.begin() + aVar.dimids[1] });
+        };
+
+        cdf_writer(std::make_shared<random_access_file>("Data/testing9.nc", random_access_file::create), true)
+            .write_reordered(cdf, var_it, dims_of(cdf, *var_it), pool);
+
+        assert(!cdf.get_var("tas")->is_loaded());
+
+        // The same as reordering the var in memory first.
+        auto & loaded = netcdf{};
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true) >> loaded;
+
+        auto loaded_it = loaded.get_var("tas");
+
+        loaded.reorder_var(loaded_it, dims_of(loaded, *loaded_it), pool);
+
+        auto const & theData = cdf.get_var("tas")->get_data();
+
+        assert(theData.size() == loaded_it->data.size());
+        assert(!memcmp(theData.data(), loaded_it->data.data(), theData.size_in_bytes()));
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true).read_header(cdf);
+
+        // Names resolve by way of the index built on read, and may not be added twice.
+        auto var_it = cdf.get_var("tas");
+
+        assert(var_it != cdf.vars.end() && var_it->name == "tas");
+        assert(cdf.get_var("no_such_var") == cdf.vars.end());
+
+        auto threw = false;
+
+        try {
+            cdf.add_var(var_it->name, nc_float);
+        }
+        catch (std::invalid_argument const &) {
+            threw = true;
+        }
+
+        assert(threw);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        cdf.add_dim("time", 0);
+        cdf.add_dim("x", 4);
+
+        // Record and non-record vars, added in turn, are appended, then partitioned in one go.
+        for (auto i = 0; i < 2000; i++) {
+
+            auto aVar = var("v" + std::to_string(i), nc_float);
+
+            if (i % 2)
+                aVar.dimids = { 0, 1 };
+            else
+                aVar.dimids = { 1 };
+
+            cdf.add_var(std::move(aVar));
+        }
+
+        cdf.partition_vars();
+
+        assert(std::is_partitioned(cdf.vars.begin(), cdf.vars.end(),
+            [&](var const & x) { return !x.is_record(cdf.dims); }));
+
+        assert(cdf.get_var(0)->name == "v0");
+        assert(cdf.get_var(1000)->name == "v1");
+        assert(cdf.get_var("v1999")->is_record(cdf.dims));
+
+        // Renamed through the public vector, the var is found by its new name once reindexed, and not by its old.
+        cdf.vars[5].name = "renamed";
+        cdf.reindex();
+
+        assert(cdf.get_var("renamed") == cdf.vars.begin() + 5);
+        assert(cdf.get_var("v10") == cdf.vars.end());
+
+        // Likewise one erased and another pushed in its place, leaving the size as it was.
+        cdf.vars.erase(cdf.vars.begin() + 7);
+        cdf.vars.push_back(var("pushed", nc_float));
+        cdf.reindex();
+
+        assert(cdf.get_var("pushed") == cdf.vars.end() - 1);
+        assert(cdf.get_var("v1999") != cdf.vars.end());
+    }
+
+    {
+        struct named_item { std::string name; };
+
+        name_index index;
+        std::vector<named_item> items;
+
+        // Adding checks for a duplicate first, which is a miss every time, and must not walk the items.
+        for (auto i = 0; i < 5000; i++) {
+
+            const auto name = "d" + std::to_string(i);
+
+            assert(index.find(items, name) == items.end());
+
+            items.push_back(named_item{ name });
+            index.inserted(items, items.end() - 1);
+        }
+
+        // Built once, when there came to be more than a few, and kept up since.
+        assert(index.get_rebuild_count() == 1);
+        assert(index.find(items, "d4321") == items.begin() + 4321);
+        assert(index.get_rebuild_count() == 1);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        // Room made up front, the vars go in without moving, however many there are.
+        cdf.reserve_dims(1);
+        cdf.reserve_vars(3000);
+        cdf.reserve_attrs(40);
+
+        cdf.add_dim("x", 2);
+
+        auto first = &cdf.add_var("v0", nc_float)->name;
+
+        for (auto i = 1; i < 3000; i++)
+            cdf.add_var("v" + std::to_string(i), nc_float);
+
+        for (auto i = 0; i < 40; i++)
+            cdf.add_text_attr("a" + std::to_string(i), "text");
+
+        assert(&cdf.vars.front().name == first);
+        assert(cdf.get_var("v2999") == cdf.vars.end() - 1);
+        assert(cdf.get_attr("a39") == cdf.attrs.end() - 1);
+
+        bool threw = false;
+
+        try {
+            cdf.add_var("v1234", nc_int);
+        }
+        catch (std::invalid_argument const &) {
+            threw = true;
+        }
+
+        assert(threw);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        // A few attrs are searched, more are indexed; either way the names resolve.
+        for (auto i = 0; i < 100; i++)
+            cdf.add_text_attr("a" + std::to_string(i), std::string(32, 'x'));
+
+        assert(cdf.get_attr("a7")->values.front().text.size() == 32);
+        assert(cdf.get_attr("a99") == cdf.attrs.end() - 1);
+
+        // Moved, the model takes its text and values along rather than copying them.
+        auto text = cdf.attrs.front().values.front().text.data();
+
+        auto moved = std::move(cdf);
+
+        assert(moved.attrs.size() == 100 && cdf.attrs.empty());
+        assert(moved.attrs.front().values.front().text.data() == text);
+        assert(moved.get_attr("a42") == moved.attrs.begin() + 42);
+    }
+
+    {
+        auto & cdf = netcdf{};
+        auto & copy = netcdf{};
+
+        {
+            memory_arena arena;
+            auto & inArena = netcdf{};
+
+            std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+            cdf_reader(&ifs, true).read_header(inArena, arena);
+
+            assert(inArena.vars.get_allocator().arena == &arena);
+            assert(inArena.get_var("tas")->attrs.get_allocator().arena == &arena);
+            assert(arena.get_allocated_size() > 0 && arena.get_block_count() <= 2);
+
+            // A copy is made on the heap, and outlives the arena.
+            copy = netcdf(inArena);
+
+            assert(copy.vars.get_allocator().arena == nullptr);
+        }
+
+        std::ifstream ifs("Data/sresa1b_ncar_ccsm3-example.nc", std::ios::binary);
+
+        cdf_reader(&ifs, true).read_header(cdf);
+
+        assert(copy.vars.size() == cdf.vars.size() && copy.attrs.size() == cdf.attrs.size());
+        assert(copy.get_var("tas")->dimids == cdf.get_var("tas")->dimids);
+        assert(copy.get_attr("title")->values.front().text == cdf.get_attr("title")->values.front().text);
+    }
+
+    {
+        auto & cdf = netcdf{};
+
+        std::ofstream ofs("Data/testing2.nc", std::ios::binary);
+
+        cdf_writer(&ofs, false) << cdf;
+    }
+
+    return 0;
+}
@@ -1,128 +1,526 @@
-
-#include "netcdf.h"
-
-#include <algorithm>
-
-///////////////////////////////////////////////////////////////////////////////
-
-netcdf::netcdf()
-    : attributable()
-    , magic()
-    , numrecs(0)
-    , dims()
-    , vars() {
-}
-
-netcdf::netcdf(netcdf const & other)
-    : attributable(other)
-    , magic(other.magic)
-    , numrecs(other.numrecs)
-    , dims(other.dims)
-    , vars(other.vars) {
-}
-
-netcdf::~netcdf() {
-}
-
-dim_vector::iterator netcdf::add_dim(dim const & theDim, int32_t default_dim_length) {
-
-    //TODO: TBD: may also mean needing to rearrange variables for record/non-record data purposes ...
-    // There may be 0-1 unlimited (record) dims.
-    if (theDim.is_record()) {
-        for (auto & aDim : dims)
-            if (aDim.is_record())
-                aDim.dim_length = default_dim_length;
-    }
-
-    // Insert the dimension at the end of the vector.
-    return dims.insert(dims.end(), theDim);
-}
-
-dim_vector::iterator netcdf::add_dim(std::string const & name, int32_t dim_length, int32_t default_dim_length) {
-    return add_dim(dim(name, dim_length), default_dim_length);
-}
-
-void netcdf::set_unlimited_dim(dim_vector::iterator dim_it, int32_t default_dim_length) {
-
-    for (auto it = dims.begin(); it != dims.end(); it++) {
-
-        if (it->is_record())
-            it->dim_length = default_dim_length;
-
-        if (it == dim_it)
-            it->dim_length = 0;
-    }
-}
-
-void netcdf::set_unlimited_dim(dim_vector::size_type const & i, int32_t default_dim_length) {
-
-    auto dim_it = get_dim(i);
-
-    set_unlimited_dim(dim_it, default_dim_length);
-}
-
-void netcdf::set_unlimited_dim(std::string const & name, int32_t default_dim_length) {
-
-    auto dim_it = get_dim(name);
-
-    set_unlimited_dim(dim_it, default_dim_length);
-}
-
-var_vector::iterator netcdf::add_var(var const & theVar) {
-
-    // Record variables go at the end of the vector.
-    var_vector::iterator where_it = vars.end();
-
-    // Non-record variables go at the end of the non-record variables.
-    if (!theVar.is_record(dims)) {
-        for (auto it = vars.begin(); it != vars.end(); it++)
-            if (!it->is_record(dims)) where_it = it;
-    }
-
-    return vars.insert(where_it, theVar);
-}
-
-var_vector::iterator netcdf::add_var(std::string  & name, nc_type theType) {
-    return add_var(var(name, theType));
-}
-
-var_vector::iterator netcdf::get_var(var_vector::size_type i) {
-    return vars.begin() + i;
-}
-
-var_vector::iterator netcdf::get_var(std::string const & name) {
-    return std::find_if(vars.begin(), vars.end(),
-        [&](var const & x) { return x.name == name; });
-}
-
-dim_vector::iterator netcdf::get_dim(dim_vector::size_type i) {
-    return dims.begin() + i;
-}
-
-dim_vector::iterator netcdf::get_dim(std::string const & name) {
-    return std::find_if(dims.begin(), dims.end(),
-        [&](dim const & x) { return x.name == name; });
-}
-
-void netcdf::redim_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its) {
-
-    //TODO: TBD: just return? or throw?
-    if (var_it == vars.end()) return;
-
-    var_it->dimids.clear();
-
-    auto dim_begin = dims.begin();
-
-    for (auto & dim_it : dim_its)
-        var_it->dimids.push_back(dim_it - dim_begin);
-
-    //TODO: what else to do with the type / data ?
-}
-
-void netcdf::redim_var(var_vector::size_type i, dim_vector_iterator_vector const & dim_its) {
-    redim_var(get_var(i), dim_its);
-}
-
-void netcdf::redim_var(std::string const & name, dim_vector_iterator_vector const & dim_its) {
-    redim_var(get_var(name), dim_its);
-}
+
+#include "netcdf.h"
+#include "io/network_byte_order.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+const int64_t netcdf::streaming;
+
+netcdf::netcdf()
+    : attributable()
+    , magic()
+    , numrecs(0)
+    , dims()
+    , vars()
+    , dim_names()
+    , var_names()
+    , partition_pending(false) {
+}
+
+netcdf::netcdf(netcdf const & other)
+    : attributable(other)
+    , magic(other.magic)
+    , numrecs(other.numrecs)
+    , dims(other.dims)
+    , vars(other.vars)
+    , dim_names(other.dim_names)
+    , var_names(other.var_names)
+    , partition_pending(other.partition_pending) {
+}
+
+netcdf::netcdf(netcdf && other) noexcept
+    : attributable(std::move(other))
+    , magic(other.magic)
+    , numrecs(other.numrecs)
+    , dims(std::move(other.dims))
+    , vars(std::move(other.vars))
+    , dim_names(std::move(other.dim_names))
+    , var_names(std::move(other.var_names))
+    , partition_pending(other.partition_pending) {
+}
+
+netcdf & netcdf::operator=(netcdf const & other) {
+    attributable::operator=(other);
+    magic = other.magic;
+    numrecs = other.numrecs;
+    dims = other.dims;
+    vars = other.vars;
+    dim_names = other.dim_names;
+    var_names = other.var_names;
+    partition_pending = other.partition_pending;
+    return *this;
+}
+
+netcdf & netcdf::operator=(netcdf && other) noexcept {
+    attributable::operator=(std::move(other));
+    magic = other.magic;
+    numrecs = other.numrecs;
+    dims = std::move(other.dims);
+    vars = std::move(other.vars);
+    dim_names = std::move(other.dim_names);
+    var_names = std::move(other.var_names);
+    partition_pending = other.partition_pending;
+    return *this;
+}
+
+netcdf::~netcdf() {
+}
+
+dim_vector::iterator netcdf::add_dim(dim const & theDim, int64_t default_dim_length) {
+    return add_dim(dim(theDim), default_dim_length);
+}
+
+dim_vector::iterator netcdf::add_dim(dim && theDim, int64_t default_dim_length) {
+
+    if (get_dim(theDim.name) != dims.end())
+        throw std::invalid_argument("duplicate dim name");
+
+    // There may be 0-1 unlimited (record) dims; the vars of a former one are no longer record vars.
+    if (theDim.is_record()) {
+        for (auto & aDim : dims) {
+            if (aDim.is_record()) {
+                aDim.dim_length = default_dim_length;
+                partition_pending = !vars.empty();
+            }
+        }
+    }
+
+    // Insert the dimension at the end of the vector.
+    auto dim_it = dims.insert(dims.end(), std::move(theDim));
+
+    dim_names.inserted(dims, dim_it);
+
+    return dim_it;
+}
+
+dim_vector::iterator netcdf::add_dim(std::string const & name, int64_t dim_length, int64_t default_dim_length) {
+    return add_dim(dim(name, dim_length), default_dim_length);
+}
+
+void netcdf::reserve_dims(dim_vector::size_type n) {
+    dims.reserve(n);
+    dim_names.reserve(n);
+}
+
+void netcdf::reserve_vars(var_vector::size_type n) {
+    vars.reserve(n);
+    var_names.reserve(n);
+}
+
+void netcdf::set_unlimited_dim(dim_vector::iterator dim_it, int64_t default_dim_length) {
+
+    for (auto it = dims.begin(); it != dims.end(); it++) {
+
+        if (it->is_record())
+            it->dim_length = default_dim_length;
+
+        if (it == dim_it)
+            it->dim_length = 0;
+    }
+
+    // Which vars are record vars may well have changed.
+    partition_pending = !vars.empty();
+}
+
+void netcdf::set_unlimited_dim(dim_vector::size_type const & i, int64_t default_dim_length) {
+
+    auto dim_it = get_dim(i);
+
+    set_unlimited_dim(dim_it, default_dim_length);
+}
+
+void netcdf::set_unlimited_dim(std::string const & name, int64_t default_dim_length) {
+
+    auto dim_it = get_dim(name);
+
+    set_unlimited_dim(dim_it, default_dim_length);
+}
+
+var_vector::iterator netcdf::add_var(var const & theVar) {
+    return add_var(var(theVar));
+}
+
+var_vector::iterator netcdf::add_var(var && theVar) {
+
+    if (get_var(theVar.name) != vars.end())
+        throw std::invalid_argument("duplicate var name");
+
+    // A non-record var behind a record var leaves the vars to be partitioned.
+    if (!vars.empty() && !theVar.is_record(dims) && vars.back().is_record(dims))
+        partition_pending = true;
+
+    vars.push_back(std::move(theVar));
+
+    auto var_it = vars.end() - 1;
+
+    var_names.inserted(vars, var_it);
+
+    return var_it;
+}
+
+var_vector::iterator netcdf::add_var(std::string const & name, nc_type theType) {
+    return add_var(var(name, theType));
+}
+
+var_vector::iterator netcdf::get_var(var_vector::size_type i) {
+    partition_vars();
+    return vars.begin() + i;
+}
+
+var_vector::iterator netcdf::get_var(std::string const & name) {
+    return var_names.find(vars, name);
+}
+
+dim_vector::iterator netcdf::get_dim(dim_vector::size_type i) {
+    return dims.begin() + i;
+}
+
+dim_vector::iterator netcdf::get_dim(std::string const & name) {
+    return dim_names.find(dims, name);
+}
+
+void netcdf::redim_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its) {
+
+    //TODO: TBD: just return? or throw?
+    if (var_it == vars.end()) return;
+
+    const auto was_record = var_it->is_record(dims);
+
+    var_it->dimids.clear();
+
+    auto dim_begin = dims.begin();
+
+    for (auto & dim_it : dim_its)
+        var_it->dimids.push_back(dim_it - dim_begin);
+
+    if (var_it->is_record(dims) != was_record)
+        partition_pending = true;
+
+    // The data is left as it is; see reorder_var to put it in the order of the dims as well.
+}
+
+void netcdf::redim_var(var_vector::size_type i, dim_vector_iterator_vector const & dim_its) {
+    redim_var(get_var(i), dim_its);
+}
+
+void netcdf::redim_var(std::string const & name, dim_vector_iterator_vector const & dim_its) {
+    redim_var(get_var(name), dim_its);
+}
+
+axis_vector netcdf::get_axes(var const & theVar, dim_vector_iterator_vector const & dim_its) const {
+
+    if (dim_its.size() != theVar.dimids.size())
+        throw std::invalid_argument("dims do not match the var");
+
+    axis_vector axes;
+
+    // A dim may appear more than once, i.e. a square matrix; each one given takes the next not yet taken.
+    std::vector<bool> taken(theVar.dimids.size(), false);
+
+    for (auto & dim_it : dim_its) {
+
+        const auto dimid = static_cast<int32_t>(dim_it - dims.begin());
+
+        dimid_vector::size_type k = 0;
+
+        while (k < theVar.dimids.size() && (taken[k] || theVar.dimids[k] != dimid))
+            k++;
+
+        if (k == theVar.dimids.size())
+            throw std::invalid_argument("dim is not a dim of the var");
+
+        taken[k] = true;
+        axes.push_back(k);
+    }
+
+    // The record dim, when there is one, comes first in any var.
+    if (theVar.is_record(dims) && axes.front() != 0)
+        throw std::invalid_argument("the record dim must stay first");
+
+    return axes;
+}
+
+void netcdf::reorder_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its, thread_pool * pPool) {
+
+    if (var_it == vars.end())
+        throw std::invalid_argument("var not found");
+
+    auto & theVar = *var_it;
+
+    const auto axes = get_axes(theVar, dim_its);
+
+    auto const & theData = theVar.get_data();
+
+    // The record dim, if any, holds however many records the data does.
+    auto shape = get_shape(theVar);
+
+    const auto record_nelems = theVar.get_nelems(dims);
+
+    if (theVar.is_record(dims))
+        shape.front() = record_nelems ? static_cast<int64_t>(theData.size() / record_nelems) : 0;
+
+    const auto width = data_buffer::get_element_size(theData.get_type());
+
+    data_buffer reordered;
+
+    reordered.assign_uninitialized(theData.get_type(), theData.size());
+
+    // The bytes are moved as they are, and a view still in file byte order is put in host order after.
+    if (pPool)
+        permute_elements(theData.bytes(), reordered.data(), width, shape, axes, *pPool);
+    else
+        permute_elements(theData.bytes(), reordered.data(), width, shape, axes);
+
+    if (!theData.is_host_order())
+        swap_endian_array(reordered.data(), width, reordered.size());
+
+    theVar.data = std::move(reordered);
+    theVar.loader.reset();
+
+    redim_var(var_it, dim_its);
+}
+
+void netcdf::reorder_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its) {
+    reorder_var(var_it, dim_its, nullptr);
+}
+
+void netcdf::reorder_var(var_vector::size_type i, dim_vector_iterator_vector const & dim_its) {
+    reorder_var(get_var(i), dim_its, nullptr);
+}
+
+void netcdf::reorder_var(std::string const & name, dim_vector_iterator_vector const & dim_its) {
+    reorder_var(get_var(name), dim_its, nullptr);
+}
+
+void netcdf::reorder_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its, thread_pool & pool) {
+    reorder_var(var_it, dim_its, &pool);
+}
+
+void netcdf::reorder_var(var_vector::size_type i, dim_vector_iterator_vector const & dim_its, thread_pool & pool) {
+    reorder_var(get_var(i), dim_its, &pool);
+}
+
+void netcdf::reorder_var(std::string const & name, dim_vector_iterator_vector const & dim_its, thread_pool & pool) {
+    reorder_var(get_var(name), dim_its, &pool);
+}
+
+void netcdf::partition_vars() {
+
+    if (!partition_pending) return;
+
+    std::stable_partition(vars.begin(), vars.end(),
+        [&](var const & x) { return !x.is_record(dims); });
+
+    var_names.clear();
+
+    partition_pending = false;
+}
+
+template<class _Future>
+static _Future make_ready_future() {
+    std::promise<void> done;
+    done.set_value();
+    return _Future(done.get_future());
+}
+
+std::shared_future<void> netcdf::prefetch_var(var_vector::iterator var_it, thread_pool & pool) {
+
+    if (var_it == vars.end())
+        throw std::invalid_argument("var not found");
+
+    auto & theVar = *var_it;
+
+    if (theVar.is_prefetching())
+        return theVar.prefetch;
+
+    if (theVar.is_loaded())
+        return make_ready_future<std::shared_future<void>>();
+
+    auto loader = theVar.loader;
+    // The load goes by a copy of the header, such that the var itself may move meanwhile.
+    auto header = std::make_shared<var>(theVar.get_header());
+    auto theData = std::make_shared<data_buffer>();
+
+    theVar.prefetch = pool.async([=]() { loader->load(*header, *theData); }).share();
+    theVar.prefetched = theData;
+
+    return theVar.prefetch;
+}
+
+std::shared_future<void> netcdf::prefetch_var(var_vector::size_type i, thread_pool & pool) {
+    return prefetch_var(get_var(i), pool);
+}
+
+std::shared_future<void> netcdf::prefetch_var(std::string const & name, thread_pool & pool) {
+    return prefetch_var(get_var(name), pool);
+}
+
+std::future<void> netcdf::read_slab_async(var_vector::iterator var_it, slab const & theSlab, data_buffer & theData, thread_pool & pool) {
+
+    if (var_it == vars.end())
+        throw std::invalid_argument("var not found");
+
+    if (var_it->is_loaded()) {
+        read_slab(var_it, theSlab, theData);
+        return make_ready_future<std::future<void>>();
+    }
+
+    const auto shape = get_shape(*var_it);
+
+    theSlab.validate(shape);
+
+    theData.assign_uninitialized(var_it->get_type(), static_cast<data_buffer::size_type>(theSlab.get_nelems()));
+
+    auto loader = var_it->loader;
+    auto header = std::make_shared<var>(var_it->get_header());
+    auto pData = &theData;
+
+    return pool.async([=]() { loader->read_slab(*header, theSlab, shape, *pData); });
+}
+
+std::future<void> netcdf::read_slab_async(var_vector::size_type i, slab const & theSlab, data_buffer & theData, thread_pool & pool) {
+    return read_slab_async(get_var(i), theSlab, theData, pool);
+}
+
+std::future<void> netcdf::read_slab_async(std::string const & name, slab const & theSlab, data_buffer & theData, thread_pool & pool) {
+    return read_slab_async(get_var(name), theSlab, theData, pool);
+}
+
+void netcdf::load_vars() {
+    for (auto & aVar : vars)
+        aVar.load();
+}
+
+void netcdf::load_vars(thread_pool & pool) {
+
+    // Vars read together share a loader, and are loaded together.
+    std::map<data_loader *, std::vector<var *>> pending;
+
+    for (auto & aVar : vars)
+        if (!aVar.is_loaded() && !aVar.is_prefetching())
+            pending[aVar.loader.get()].push_back(&aVar);
+
+    for (auto & x : pending) {
+
+        x.first->load(x.second, pool);
+
+        for (auto pVar : x.second)
+            pVar->loaded = true;
+    }
+
+    // Vars already on their way in are waited for rather than loaded again.
+    for (auto & aVar : vars)
+        if (aVar.is_prefetching())
+            aVar.load();
+}
+
+void netcdf::unload_vars() {
+    for (auto & aVar : vars)
+        aVar.unload();
+}
+
+int64_t netcdf::get_recsize() const {
+
+    int64_t result = 0;
+
+    var const * pRecordVar = nullptr;
+    int count = 0;
+
+    for (auto & aVar : vars) {
+        if (aVar.is_record(dims)) {
+            result += aVar.vsize;
+            pRecordVar = &aVar;
+            count++;
+        }
+    }
+
+    if (count == 1)
+        result = pRecordVar->get_nelems(dims) * data_buffer::get_element_size(pRecordVar->get_type());
+
+    return result;
+}
+
+slab::index_vector netcdf::get_shape(var const & theVar) const {
+
+    slab::index_vector shape;
+
+    for (auto & dimid : theVar.dimids) {
+        auto & theDim = dims[dimid];
+        shape.push_back(theDim.is_record() ? numrecs : theDim.dim_length);
+    }
+
+    return shape;
+}
+
+void netcdf::read_slab(var_vector::iterator var_it, slab const & theSlab, data_buffer & theData) {
+
+    if (var_it == vars.end())
+        throw std::invalid_argument("var not found");
+
+    const auto shape = get_shape(*var_it);
+
+    theSlab.validate(shape);
+
+    const auto type = var_it->get_type();
+
+    // Every element of the slab is read over, so there is no need to clear them first.
+    theData.assign_uninitialized(type, static_cast<data_buffer::size_type>(theSlab.get_nelems()));
+
+    const auto is_record = var_it->is_record(dims);
+
+    if (!var_it->is_loaded()) {
+        var_it->loader->read_slab(*var_it, theSlab, shape, theData);
+        return;
+    }
+
+    // Otherwise the slab is gathered from the data in memory, which has each record back to back.
+    int64_t record_nelems = 1;
+
+    for (slab::index_vector::size_type i = is_record ? 1 : 0; i < shape.size(); i++)
+        record_nelems *= shape[i];
+
+    auto const & source = var_it->data;
+
+    if (static_cast<int64_t>(source.size()) < record_nelems * (is_record ? numrecs : 1))
+        throw std::out_of_range("slab exceeds the var data");
+
+    const auto width = static_cast<int64_t>(data_buffer::get_element_size(type));
+
+    auto src = static_cast<char const *>(source.bytes());
+    auto dest = static_cast<char *>(theData.data());
+
+    theSlab.for_each_run(shape, is_record,
+        [&](int64_t record, int64_t offset, int64_t slab_offset, int64_t nelems) {
+        memcpy(dest + slab_offset * width, src + (record * record_nelems + offset) * width,
+            static_cast<std::size_t>(nelems * width));
+    });
+
+    // Gathered from a view still in file byte order, the slab is put in host order after.
+    if (!source.is_host_order())
+        swap_endian_array(dest, static_cast<std::size_t>(width), theData.size());
+}
+
+void netcdf::read_slab(var_vector::size_type i, slab const & theSlab, data_buffer & theData) {
+    read_slab(get_var(i), theSlab, theData);
+}
+
+void netcdf::read_slab(std::string const & name, slab const & theSlab, data_buffer & theData) {
+    read_slab(get_var(name), theSlab, theData);
+}
+
+void netcdf::reindex() {
+
+    attributable::reindex();
+
+    dim_names.clear();
+    var_names.clear();
+
+    for (auto & aVar : vars)
+        aVar.reindex();
+}
@@ -1,59 +1,149 @@
-#ifndef NETCDF_FILE_H
-#define NETCDF_FILE_H
-
-#pragma once
-
-#include "parts/magic.h"
-#include "parts/dim.h"
-#include "parts/var.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct netcdf : public attributable {
-public:
-
-    typedef std::vector<dim_vector::iterator> dim_vector_iterator_vector;
-
-    magic magic;
-
-    //TODO: upwards of MAX_INT32 (yes, that's 0xffffffff, or STREAMING) ...
-    //TODO: TBD: numrecs could (/should) be more of a dynamic get function?
-    int32_t numrecs;
-
-    dim_vector dims;
-
-    var_vector vars;
-
-    netcdf();
-    netcdf(netcdf const & other);
-
-    virtual ~netcdf();
-
-    virtual dim_vector::iterator add_dim(dim const & aDim, int32_t default_dim_length = 1);
-    virtual dim_vector::iterator add_dim(std::string const & name, int32_t dim_length = 1, int32_t default_dim_length = 1);
-
-    virtual dim_vector::iterator get_dim(dim_vector::size_type i);
-    virtual dim_vector::iterator get_dim(std::string const & name);
-
-    virtual void set_unlimited_dim(dim_vector::iterator dim_it, int32_t default_dim_length = 1);
-    virtual void set_unlimited_dim(dim_vector::size_type const & i, int32_t default_dim_length = 1);
-    virtual void set_unlimited_dim(std::string const & name, int32_t default_dim_length = 1);
-
-    virtual var_vector::iterator add_var(var const & aVar);
-    virtual var_vector::iterator add_var(std::string  & name, nc_type aType);
-
-    virtual var_vector::iterator get_var(var_vector::size_type i);
-    virtual var_vector::iterator get_var(std::string const & name);
-
-    virtual void redim_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its);
-    virtual void redim_var(var_vector::size_type i, dim_vector_iterator_vector const & dim_its);
-    virtual void redim_var(std::string const & name, dim_vector_iterator_vector const & dim_its);
-};
-
-/* TODO: TBD: still to come, how to work with the "shape" of data via the netcdf;
-that's the whole point of utilizing the format, that data can be shaped and worked with
-TBD: could be some "operators" that permit definition, mutation, access, and so on;
-might be interesting to consider whether variadics hold any value for accessing values
-along a range of values */
-
-#endif //NETCDF_FILE_H
+#ifndef NETCDF_FILE_H
+#define NETCDF_FILE_H
+
+#pragma once
+
+#include "parts/magic.h"
+#include "parts/dim.h"
+#include "parts/var.h"
+#include "parts/slab.h"
+#include "parts/permute.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct netcdf : public attributable {
+public:
+
+    typedef std::vector<dim_vector::iterator> dim_vector_iterator_vector;
+
+    ::magic magic;
+
+    // The numrecs of a file whose records are still being written, i.e. STREAMING, all ones.
+    static const int64_t streaming = -1;
+
+    //TODO: TBD: numrecs could (/should) be more of a dynamic get function?
+    int64_t numrecs;
+
+    dim_vector dims;
+
+    var_vector vars;
+
+    netcdf();
+    netcdf(netcdf const & other);
+    netcdf(netcdf && other) noexcept;
+
+    netcdf & operator=(netcdf const & other);
+    netcdf & operator=(netcdf && other) noexcept;
+
+    virtual ~netcdf();
+
+    virtual dim_vector::iterator add_dim(dim const & aDim, int64_t default_dim_length = 1);
+    virtual dim_vector::iterator add_dim(dim && aDim, int64_t default_dim_length = 1);
+    virtual dim_vector::iterator add_dim(std::string const & name, int64_t dim_length = 1, int64_t default_dim_length = 1);
+
+    /* Makes room for as many dims, or vars, and their names, such that adding that many reallocates
+    neither the vector nor its name index; the duplicate check of every add is O(1) either way. */
+    virtual void reserve_dims(dim_vector::size_type n);
+    virtual void reserve_vars(var_vector::size_type n);
+
+    virtual dim_vector::iterator get_dim(dim_vector::size_type i);
+    virtual dim_vector::iterator get_dim(std::string const & name);
+
+    virtual void set_unlimited_dim(dim_vector::iterator dim_it, int64_t default_dim_length = 1);
+    virtual void set_unlimited_dim(dim_vector::size_type const & i, int64_t default_dim_length = 1);
+    virtual void set_unlimited_dim(std::string const & name, int64_t default_dim_length = 1);
+
+    /* Non-record vars are kept ahead of the record vars. Rather than inserting into the middle of
+    the vars, which moves every record var along, the var is appended, and the vars are partitioned
+    once, the next time their order matters; see partition_vars. */
+    virtual var_vector::iterator add_var(var const & aVar);
+    virtual var_vector::iterator add_var(var && aVar);
+    virtual var_vector::iterator add_var(std::string const & name, nc_type aType);
+
+    // Positions are as partitioned, the vars being partitioned first if need be.
+    virtual var_vector::iterator get_var(var_vector::size_type i);
+    virtual var_vector::iterator get_var(std::string const & name);
+
+    virtual void redim_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its);
+    virtual void redim_var(var_vector::size_type i, dim_vector_iterator_vector const & dim_its);
+    virtual void redim_var(std::string const & name, dim_vector_iterator_vector const & dim_its);
+
+    /* Returns the axes that take the var from its dims to the same dims in the order given, i.e.
+    dim d of the one is dim axes[d] of the other; throws unless the dims given are the var's own,
+    with the record dim, if any, still first. */
+    virtual axis_vector get_axes(var const & aVar, dim_vector_iterator_vector const & dim_its) const;
+
+    /* Puts the dims of the var in the order given, as redim_var does, and the data along with them,
+    in memory, loading it first if need be; see permute_elements. The data no longer being as it
+    was loaded, the var is detached from where it was loaded from. Given a pool, the data is put in
+    order across it. To reorder a var too large for memory, see cdf_writer::write_reordered. */
+    virtual void reorder_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its);
+    virtual void reorder_var(var_vector::size_type i, dim_vector_iterator_vector const & dim_its);
+    virtual void reorder_var(std::string const & name, dim_vector_iterator_vector const & dim_its);
+
+    virtual void reorder_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its, thread_pool & pool);
+    virtual void reorder_var(var_vector::size_type i, dim_vector_iterator_vector const & dim_its, thread_pool & pool);
+    virtual void reorder_var(std::string const & name, dim_vector_iterator_vector const & dim_its, thread_pool & pool);
+
+    /* Moves any non-record vars that have fallen behind record vars ahead of them, keeping the
+    order otherwise, in one pass. Iterators into the vars are invalidated when there is anything
+    to move, otherwise this costs nothing. */
+    virtual void partition_vars();
+
+    /* Returns the distance, in bytes, from one record to the next: the vsizes of the record vars
+    added together, except that a lone record var is not padded. The vsizes must be current, i.e.
+    as read, or as written. */
+    virtual int64_t get_recsize() const;
+
+    // Returns the lengths along the dimids of the var, counting numrecs for the record dim.
+    virtual slab::index_vector get_shape(var const & aVar) const;
+
+    /* Reads the slab of the var into the data, from memory when the var is loaded, otherwise
+    from wherever it would be loaded from, reading only the bytes the slab covers. */
+    virtual void read_slab(var_vector::iterator var_it, slab const & aSlab, data_buffer & theData);
+    virtual void read_slab(var_vector::size_type i, slab const & aSlab, data_buffer & theData);
+    virtual void read_slab(std::string const & name, slab const & aSlab, data_buffer & theData);
+
+    /* Starts loading the var on the pool, i.e. a thread or two set aside for I/O, and returns at
+    once, such that the caller may get on with other vars meanwhile. The data is loaded into a
+    buffer of its own, and handed to the var the next time it is asked for, waiting for it then
+    if need be; see var::get_data. A var already loaded, or prefetching, is left as it is. */
+    virtual std::shared_future<void> prefetch_var(var_vector::iterator var_it, thread_pool & pool);
+    virtual std::shared_future<void> prefetch_var(var_vector::size_type i, thread_pool & pool);
+    virtual std::shared_future<void> prefetch_var(std::string const & name, thread_pool & pool);
+
+    /* As read_slab, but on the pool, returning at once. The data is assigned there and then, and
+    must be left alone until the future is ready. The slab of a loaded var is simply gathered from
+    memory, and the future is ready on return. */
+    virtual std::future<void> read_slab_async(var_vector::iterator var_it, slab const & aSlab, data_buffer & theData, thread_pool & pool);
+    virtual std::future<void> read_slab_async(var_vector::size_type i, slab const & aSlab, data_buffer & theData, thread_pool & pool);
+    virtual std::future<void> read_slab_async(std::string const & name, slab const & aSlab, data_buffer & theData, thread_pool & pool);
+
+    // Loads, or releases, the data of every var; see var::load and var::unload.
+    virtual void load_vars();
+
+    // Loads every var not yet loaded, spreading the work across the pool; see data_loader::load. Prefetches are waited for.
+    virtual void load_vars(thread_pool & pool);
+    virtual void unload_vars();
+
+    // Drops the name indexes of the dims, vars and attrs, the vars' attrs included, to be rebuilt when next used.
+    virtual void reindex();
+
+protected:
+
+    void reorder_var(var_vector::iterator var_it, dim_vector_iterator_vector const & dim_its, thread_pool * pPool);
+
+    name_index dim_names;
+    name_index var_names;
+
+    // Set when a var was added, or redimmed, out of partition.
+    bool partition_pending;
+};
+
+/* TODO: TBD: still to come, how to work with the "shape" of data via the netcdf;
+that's the whole point of utilizing the format, that data can be shaped and worked with
+TBD: could be some "operators" that permit definition, mutation, access, and so on;
+might be interesting to consider whether variadics hold any value for accessing values
+along a range of values */
+
+#endif //NETCDF_FILE_H
@@ -0,0 +1,73 @@
+#ifndef NETCDF_ARENA_ALLOCATOR_HPP
+#define NETCDF_ARENA_ALLOCATOR_HPP
+
+#pragma once
+
+#include "memory_arena.h"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Allocates from a memory_arena, when given one, otherwise from the heap, as std::allocator
+would. The model's vectors all use it, such that a header may be read into an arena, while
+anything built by hand, by default, is not.
+
+Vectors moved, or swapped, take their arena with them. Copies do not: a copy is made on the
+heap, which is the way to keep any part of the model once the arena is gone. */
+template<typename _Ty>
+struct arena_allocator {
+
+    typedef _Ty value_type;
+
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::false_type propagate_on_container_copy_assignment;
+
+    memory_arena * arena;
+
+    arena_allocator() noexcept
+        : arena(nullptr) {
+    }
+
+    arena_allocator(memory_arena * arena) noexcept
+        : arena(arena) {
+    }
+
+    template<typename _Other>
+    arena_allocator(arena_allocator<_Other> const & other) noexcept
+        : arena(other.arena) {
+    }
+
+    _Ty * allocate(std::size_t n) {
+
+        if (arena)
+            return static_cast<_Ty *>(arena->allocate(n * sizeof(_Ty), alignof(_Ty)));
+
+        return static_cast<_Ty *>(::operator new(n * sizeof(_Ty)));
+    }
+
+    // Memory from the arena is only given back along with the rest of it.
+    void deallocate(_Ty * p, std::size_t) noexcept {
+        if (!arena)
+            ::operator delete(p);
+    }
+
+    arena_allocator select_on_container_copy_construction() const {
+        return arena_allocator();
+    }
+};
+
+template<typename _Ty, typename _Other>
+bool operator==(arena_allocator<_Ty> const & a, arena_allocator<_Other> const & b) {
+    return a.arena == b.arena;
+}
+
+template<typename _Ty, typename _Other>
+bool operator!=(arena_allocator<_Ty> const & a, arena_allocator<_Other> const & b) {
+    return a.arena != b.arena;
+}
+
+#endif //NETCDF_ARENA_ALLOCATOR_HPP
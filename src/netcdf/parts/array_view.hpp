@@ -0,0 +1,310 @@
+#ifndef NETCDF_ARRAY_VIEW_HPP
+#define NETCDF_ARRAY_VIEW_HPP
+
+#pragma once
+
+#include "dim.h"
+#include "var.h"
+#include "slab.h"
+
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* An N-dimensional view of elements of _Ty held elsewhere, i.e. the data of a var, by way of
+an extent and a stride, in elements, along each dim. Nothing is ever copied: subviews, slices
+and transposed views are views of the same elements, only with the extents and strides worked
+out again. The view is only good for as long as the data it refers to is left where it is.
+
+Made from a var, the extents are the dim lengths along its dimids, the record dim being however
+many records the data holds, and the strides are row-major, the same as the var itself.
+
+    auto tas = array_view<float const>(cdf.vars[i], cdf.dims);
+    auto first = tas.slice(0, 0);
+    auto lat_lon = tas.transposed();
+    ... */
+template<typename _Ty>
+struct array_view {
+
+    typedef _Ty value_type;
+    typedef typename std::remove_const<_Ty>::type element_type;
+    typedef slab::index_vector index_vector;
+    typedef index_vector::size_type size_type;
+
+    // A const view is made from a const var, and is the only kind that may be.
+    typedef typename std::conditional<std::is_const<_Ty>::value, var const, var>::type var_type;
+
+    array_view()
+        : pdata(nullptr)
+        , extents()
+        , strides() {
+    }
+
+    // Views the elements at p, row-major.
+    array_view(_Ty * p, index_vector const & extents)
+        : pdata(p)
+        , extents(extents)
+        , strides(get_row_major_strides(extents)) {
+    }
+
+    array_view(_Ty * p, index_vector const & extents, index_vector const & strides)
+        : pdata(p)
+        , extents(extents)
+        , strides(strides) {
+
+        if (strides.size() != extents.size())
+            throw std::invalid_argument("strides do not match extents");
+    }
+
+    /* Views the data of the var, loading it first when it is not loaded, unless the view is
+    const, in which case the data must be loaded already. Nothing is copied: data viewed from a
+    file mapping may be viewed as const once it is in host byte order, and not as mutable at all,
+    short of data_buffer::materialize; see data_buffer::data. Throws when the data is not as many
+    elements as the dims call for, i.e. a const var not loaded, or a record var of part of a record. */
+    array_view(var_type & aVar, dim_vector const & dims)
+        : pdata(nullptr)
+        , extents()
+        , strides() {
+
+        auto & theData = get_data_of(aVar);
+
+        if (!theData.template is_data_type<element_type>())
+            throw std::invalid_argument("view type does not match var type");
+
+        const auto record_nelems = static_cast<int64_t>(aVar.get_nelems(dims));
+        const auto nelems = static_cast<int64_t>(theData.size());
+
+        // Whole records only, and none at all of nothing.
+        if (aVar.is_record(dims) && (record_nelems ? nelems % record_nelems : nelems))
+            throw std::invalid_argument("data is not a whole number of records");
+
+        for (auto & dimid : aVar.dimids) {
+            auto & theDim = dims[dimid];
+            extents.push_back(theDim.is_record()
+                ? (record_nelems ? nelems / record_nelems : 0)
+                : theDim.dim_length);
+        }
+
+        // Not loaded, or not what the dims call for, the data would be read past its end.
+        if (size() != nelems)
+            throw std::invalid_argument("data does not match dims");
+
+        strides = get_row_major_strides(extents);
+
+        pdata = static_cast<_Ty *>(theData.data());
+    }
+
+    // A view of elements of _Ty is also a view of const ones.
+    template<typename _Other, typename = typename std::enable_if<
+        std::is_same<_Ty, _Other const>::value>::type>
+    array_view(array_view<_Other> const & other)
+        : pdata(other.data())
+        , extents(other.get_extents())
+        , strides(other.get_strides()) {
+    }
+
+    _Ty * data() const {
+        return pdata;
+    }
+
+    size_type rank() const {
+        return extents.size();
+    }
+
+    int64_t extent(size_type d) const {
+        return extents.at(d);
+    }
+
+    int64_t stride(size_type d) const {
+        return strides.at(d);
+    }
+
+    index_vector const & get_extents() const {
+        return extents;
+    }
+
+    index_vector const & get_strides() const {
+        return strides;
+    }
+
+    // The number of elements viewed; one for a scalar, i.e. rank zero.
+    int64_t size() const {
+        int64_t result = 1;
+        for (auto & n : extents) result *= n;
+        return result;
+    }
+
+    bool empty() const {
+        return !pdata || !size();
+    }
+
+    // Whether the elements are row-major and back to back, i.e. may be handed on as a flat array.
+    bool is_contiguous() const {
+        return strides == get_row_major_strides(extents);
+    }
+
+    template<typename... _Index>
+    _Ty & operator()(_Index... indices) const {
+        static_assert(sizeof...(_Index) > 0, "use the index_vector overload for a scalar");
+        const int64_t index[] = { static_cast<int64_t>(indices)... };
+        return pdata[get_offset(index, sizeof...(_Index))];
+    }
+
+    _Ty & operator()(index_vector const & index) const {
+        return pdata[get_offset(index.data(), index.size())];
+    }
+
+    // As the call operator, but throws when the index is out of range.
+    _Ty & at(index_vector const & index) const {
+
+        if (index.size() != rank())
+            throw std::out_of_range("index does not match rank");
+
+        for (size_type d = 0; d < rank(); d++)
+            if (index[d] < 0 || index[d] >= extents[d])
+                throw std::out_of_range("index out of range");
+
+        return (*this)(index);
+    }
+
+    // The view at the index along the dim, i.e. one rank less; slice(0, r) is record r of a record var.
+    array_view slice(size_type d, int64_t index) const {
+
+        if (d >= rank() || index < 0 || index >= extents[d])
+            throw std::out_of_range("slice out of range");
+
+        auto theExtents = extents;
+        auto theStrides = strides;
+
+        theExtents.erase(theExtents.begin() + d);
+        theStrides.erase(theStrides.begin() + d);
+
+        return array_view(pdata + index * strides[d], theExtents, theStrides);
+    }
+
+    // The view of the slab, i.e. its start, count and stride, along each dim, in the same rank.
+    array_view subview(slab const & theSlab) const {
+
+        theSlab.validate(extents);
+
+        auto theStrides = strides;
+
+        int64_t offset = 0;
+
+        for (size_type d = 0; d < rank(); d++) {
+            offset += theSlab.start[d] * strides[d];
+            theStrides[d] *= theSlab.stride[d];
+        }
+
+        return array_view(pdata + offset, theSlab.count, theStrides);
+    }
+
+    array_view subview(index_vector const & start, index_vector const & count) const {
+        return subview(slab(start, count));
+    }
+
+    /* The same elements with the dims in the order given, i.e. axes[d] of this view becomes dim
+    d of the other. */
+    array_view transpose(std::vector<size_type> const & axes) const {
+
+        if (axes.size() != rank())
+            throw std::invalid_argument("axes do not match rank");
+
+        std::vector<bool> seen(rank(), false);
+
+        index_vector theExtents(rank());
+        index_vector theStrides(rank());
+
+        for (size_type d = 0; d < rank(); d++) {
+
+            if (axes[d] >= rank() || seen[axes[d]])
+                throw std::invalid_argument("axes are not a permutation");
+
+            seen[axes[d]] = true;
+
+            theExtents[d] = extents[axes[d]];
+            theStrides[d] = strides[axes[d]];
+        }
+
+        return array_view(pdata, theExtents, theStrides);
+    }
+
+    // The dims in reverse order, i.e. the transpose of a matrix.
+    array_view transposed() const {
+        return array_view(pdata, index_vector(extents.rbegin(), extents.rend()),
+            index_vector(strides.rbegin(), strides.rend()));
+    }
+
+    // Visits every element of the view, in row-major order of the view, whatever the strides.
+    template<typename _Function>
+    void for_each(_Function const & func) const {
+
+        if (empty()) return;
+
+        if (is_contiguous()) {
+            const auto n = size();
+            for (int64_t i = 0; i < n; i++) func(pdata[i]);
+            return;
+        }
+
+        index_vector index(rank(), 0);
+
+        for (;;) {
+
+            func(pdata[get_offset(index.data(), index.size())]);
+
+            // Count off the dims, innermost first.
+            auto d = rank();
+
+            for (; d > 0; d--) {
+                if (++index[d - 1] < extents[d - 1]) break;
+                index[d - 1] = 0;
+            }
+
+            if (!d) return;
+        }
+    }
+
+    static index_vector get_row_major_strides(index_vector const & extents) {
+
+        index_vector result(extents.size(), 1);
+
+        for (auto d = extents.size(); d > 1; d--)
+            result[d - 2] = result[d - 1] * extents[d - 1];
+
+        return result;
+    }
+
+private:
+
+    static data_buffer & get_data_of(var & aVar) {
+        return aVar.get_data();
+    }
+
+    static data_buffer const & get_data_of(var const & aVar) {
+        return aVar.data;
+    }
+
+    int64_t get_offset(int64_t const * index, size_type n) const {
+
+        assert(n == rank());
+
+        int64_t result = 0;
+
+        for (size_type d = 0; d < n; d++)
+            result += index[d] * strides[d];
+
+        return result;
+    }
+
+    _Ty * pdata;
+
+    index_vector extents;
+    index_vector strides;
+};
+
+#endif //NETCDF_ARRAY_VIEW_HPP
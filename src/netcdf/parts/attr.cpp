@@ -1,37 +1,69 @@
-
-#include "attr.h"
-#include "utils.hpp"
-
-///////////////////////////////////////////////////////////////////////////////
-
-attr::attr()
-    : named()
-    , valuable() {
-}
-
-attr::attr(std::string const & name, nc_type type)
-    : named(name)
-    , valuable(type) {
-}
-
-attr::attr(std::string const & name, std::string const & text)
-    : named(name)
-    , valuable() {
-
-    set_text(text);
-}
-
-attr::attr(attr const & other)
-    : named(other)
-    , valuable(other) {
-}
-
-void attr::set_text(std::string const & text) {
-    set_type(nc_char);
-    values = { value(text) };
-}
-
-bool attr::is_supported_type(nc_type type) {
-    return type == nc_char
-        || is_primitive_type(type);
-}
+
+#include "attr.h"
+#include "utils.hpp"
+
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+attr::attr()
+    : named()
+    , valuable() {
+}
+
+attr::attr(std::string const & name, nc_type type)
+    : named(name)
+    , valuable(type) {
+}
+
+attr::attr(std::string const & name, std::string const & text)
+    : named(name)
+    , valuable() {
+
+    set_text(text);
+}
+
+attr::attr(std::string const & name, std::string && text)
+    : named(name)
+    , valuable() {
+
+    set_text(std::move(text));
+}
+
+attr::attr(attr const & other)
+    : named(other)
+    , valuable(other) {
+}
+
+attr::attr(attr && other) noexcept
+    : named(std::move(other))
+    , valuable(std::move(other)) {
+}
+
+attr & attr::operator=(attr const & other) {
+    named::operator=(other);
+    valuable::operator=(other);
+    return *this;
+}
+
+attr & attr::operator=(attr && other) noexcept {
+    named::operator=(std::move(other));
+    valuable::operator=(std::move(other));
+    return *this;
+}
+
+void attr::set_text(std::string const & text) {
+    set_text(std::string(text));
+}
+
+// The text is moved into the one value, rather than copied through an initializer list.
+void attr::set_text(std::string && text) {
+    set_type(nc_char);
+    values.clear();
+    values.emplace_back(std::move(text));
+}
+
+bool attr::is_supported_type(nc_type type) {
+    return type == nc_char
+        || is_primitive_type(type);
+}
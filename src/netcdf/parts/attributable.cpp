@@ -1,35 +1,76 @@
-
-#include "attributable.h"
-
-#include <algorithm>
-
-///////////////////////////////////////////////////////////////////////////////
-
-attributable::attributable()
-    : attrs() {
-}
-
-attributable::attributable(attributable const & other)
-    : attrs(other.attrs) {
-}
-
-attributable::~attributable() {
-}
-
-void attributable::add_attr(attr const & theAttr) {
-    //TODO: check for things like name conflicts, etc
-    attrs.push_back(theAttr);
-}
-
-void attributable::add_text_attr(std::string const & name, std::string const & text) {
-    add_attr(attr(name, text));
-}
-
-attr_vector::iterator attributable::get_attr(attr_vector::size_type i) {
-    return attrs.begin() + i;
-}
-
-attr_vector::iterator attributable::get_attr(std::string const & name) {
-    return std::find_if(attrs.begin(), attrs.end(),
-        [&](attr const & x) { return x.name == name; });
-}
+
+#include "attributable.h"
+
+#include <stdexcept>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+attributable::attributable()
+    : attrs()
+    , attr_names() {
+}
+
+attributable::attributable(attributable const & other)
+    : attrs(other.attrs)
+    , attr_names(other.attr_names) {
+}
+
+attributable::attributable(attributable && other) noexcept
+    : attrs(std::move(other.attrs))
+    , attr_names(std::move(other.attr_names)) {
+}
+
+attributable & attributable::operator=(attributable const & other) {
+    attrs = other.attrs;
+    attr_names = other.attr_names;
+    return *this;
+}
+
+attributable & attributable::operator=(attributable && other) noexcept {
+    attrs = std::move(other.attrs);
+    attr_names = std::move(other.attr_names);
+    return *this;
+}
+
+attributable::~attributable() {
+}
+
+void attributable::add_attr(attr const & theAttr) {
+    add_attr(attr(theAttr));
+}
+
+void attributable::add_attr(attr && theAttr) {
+
+    if (get_attr(theAttr.name) != attrs.end())
+        throw std::invalid_argument("duplicate attr name");
+
+    attrs.push_back(std::move(theAttr));
+
+    attr_names.inserted(attrs, attrs.end() - 1);
+}
+
+void attributable::add_text_attr(std::string const & name, std::string const & text) {
+    add_attr(attr(name, text));
+}
+
+void attributable::add_text_attr(std::string const & name, std::string && text) {
+    add_attr(attr(name, std::move(text)));
+}
+
+void attributable::reserve_attrs(attr_vector::size_type n) {
+    attrs.reserve(n);
+    attr_names.reserve(n);
+}
+
+attr_vector::iterator attributable::get_attr(attr_vector::size_type i) {
+    return attrs.begin() + i;
+}
+
+attr_vector::iterator attributable::get_attr(std::string const & name) {
+    return attr_names.find(attrs, name);
+}
+
+void attributable::reindex() {
+    attr_names.clear();
+}
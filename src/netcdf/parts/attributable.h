@@ -1,38 +1,56 @@
-#ifndef NETCDF_ATTRIBUTABLE_H
-#define NETCDF_ATTRIBUTABLE_H
-
-#pragma once
-
-#include "attr.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct attributable {
-
-    attr_vector attrs;
-
-    virtual ~attributable();
-
-    virtual void add_attr(attr const & anAttr);
-
-    // strings are kind of like vectors but they are different enough that the use cases cannot be easily co-mingled and still be useful
-    virtual void add_text_attr(std::string const & name, std::string const & text);
-
-    //TODO: TBD: methinks that type should simply be an overloaded, inherency about how to work with attributes
-    template<class _Vector>
-    void add_attr(std::string const & name, _Vector const & values) {
-        auto & theAttr = attr(name);
-        theAttr.set_values(values);
-        add_attr(theAttr);
-    }
-
-    virtual attr_vector::iterator get_attr(attr_vector::size_type i);
-    virtual attr_vector::iterator get_attr(std::string const & name);
-
-protected:
-
-    attributable();
-    attributable(attributable const & other);
-};
-
-#endif //NETCDF_ATTRIBUTABLE_H
+#ifndef NETCDF_ATTRIBUTABLE_H
+#define NETCDF_ATTRIBUTABLE_H
+
+#pragma once
+
+#include "attr.h"
+#include "name_index.h"
+
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct attributable {
+
+    attr_vector attrs;
+
+    virtual ~attributable();
+
+    virtual void add_attr(attr const & anAttr);
+
+    // Moves the attr in, names, values and all, rather than copying it.
+    virtual void add_attr(attr && anAttr);
+
+    // strings are kind of like vectors but they are different enough that the use cases cannot be easily co-mingled and still be useful
+    virtual void add_text_attr(std::string const & name, std::string const & text);
+    virtual void add_text_attr(std::string const & name, std::string && text);
+
+    //TODO: TBD: methinks that type should simply be an overloaded, inherency about how to work with attributes
+    template<class _Vector>
+    void add_attr(std::string const & name, _Vector const & values) {
+        attr theAttr(name);
+        theAttr.set_values(values);
+        add_attr(std::move(theAttr));
+    }
+
+    // Makes room for as many attrs, and their names, such that adding that many moves none of them.
+    virtual void reserve_attrs(attr_vector::size_type n);
+
+    virtual attr_vector::iterator get_attr(attr_vector::size_type i);
+    virtual attr_vector::iterator get_attr(std::string const & name);
+
+    // Drops the name index, i.e. after the attrs were changed directly; it is rebuilt when next used.
+    virtual void reindex();
+
+protected:
+
+    name_index attr_names;
+
+    attributable();
+    attributable(attributable const & other);
+    attributable(attributable && other) noexcept;
+    attributable & operator=(attributable const & other);
+    attributable & operator=(attributable && other) noexcept;
+};
+
+#endif //NETCDF_ATTRIBUTABLE_H
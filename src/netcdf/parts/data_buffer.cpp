@@ -0,0 +1,237 @@
+#include "data_buffer.h"
+#include "../io/network_byte_order.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+void * aligned_allocate(std::size_t size, std::size_t alignment) {
+
+    // Zero length blocks are not interesting; let there be no block at all.
+    if (!size) return nullptr;
+
+#ifdef _WIN32
+    auto p = _aligned_malloc(size, alignment);
+#else
+    void * p = nullptr;
+    if (posix_memalign(&p, alignment, size)) p = nullptr;
+#endif
+
+    if (!p) throw std::bad_alloc();
+
+    return p;
+}
+
+void data_buffer::aligned_deleter::operator()(void * p) const {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+data_buffer::data_buffer()
+    : type(nc_absent)
+    , nelems(0)
+    , storage()
+    , view(nullptr)
+    , keeper()
+    , view_reversed(false) {
+}
+
+data_buffer::data_buffer(nc_type theType, size_type nelems)
+    : type(nc_absent)
+    , nelems(0)
+    , storage()
+    , view(nullptr)
+    , keeper()
+    , view_reversed(false) {
+
+    assign(theType, nelems);
+}
+
+data_buffer::data_buffer(data_buffer const & other)
+    : type(nc_absent)
+    , nelems(0)
+    , storage()
+    , view(nullptr)
+    , keeper()
+    , view_reversed(false) {
+
+    *this = other;
+}
+
+data_buffer::data_buffer(data_buffer && other) noexcept
+    : type(nc_absent)
+    , nelems(0)
+    , storage()
+    , view(nullptr)
+    , keeper()
+    , view_reversed(false) {
+
+    *this = std::move(other);
+}
+
+data_buffer & data_buffer::operator=(data_buffer const & other) {
+
+    if (this == &other) return *this;
+
+    // Views are copied as views, sharing in keeping the data alive.
+    if (other.view) {
+        assign_view(other.type, other.nelems, other.view, other.keeper, other.view_reversed);
+        return *this;
+    }
+
+    assign(other.type, other.nelems);
+
+    if (nelems)
+        memcpy(data(), other.data(), size_in_bytes());
+
+    return *this;
+}
+
+data_buffer & data_buffer::operator=(data_buffer && other) noexcept {
+
+    if (this == &other) return *this;
+
+    // The block, or the view, simply changes hands.
+    type = other.type;
+    nelems = other.nelems;
+    storage = std::move(other.storage);
+    view = other.view;
+    keeper = std::move(other.keeper);
+    view_reversed = other.view_reversed;
+
+    other.type = nc_absent;
+    other.nelems = 0;
+    other.view = nullptr;
+    other.view_reversed = false;
+
+    return *this;
+}
+
+nc_type data_buffer::get_type() const {
+    return type;
+}
+
+data_buffer::size_type data_buffer::size() const {
+    return nelems;
+}
+
+data_buffer::size_type data_buffer::size_in_bytes() const {
+    return type == nc_absent ? 0 : nelems * get_element_size(type);
+}
+
+bool data_buffer::empty() const {
+    return !nelems;
+}
+
+void data_buffer::assign(nc_type theType, size_type theNelems) {
+
+    assign_uninitialized(theType, theNelems);
+
+    if (nelems)
+        memset(storage.get(), 0, size_in_bytes());
+}
+
+void data_buffer::assign_uninitialized(nc_type theType, size_type theNelems) {
+
+    const auto size = theType == nc_absent ? 0 : theNelems * get_element_size(theType);
+
+    if (view) {
+        view = nullptr;
+        keeper.reset();
+        view_reversed = false;
+        storage.reset();
+    }
+
+    // Reuse the block when we can, otherwise trade it in for one of the new size.
+    if (!storage || size != size_in_bytes())
+        storage.reset(aligned_allocate(size, alignment));
+
+    type = theType;
+    nelems = theNelems;
+}
+
+void data_buffer::clear() {
+    storage.reset();
+    view = nullptr;
+    keeper.reset();
+    view_reversed = false;
+    nelems = 0;
+}
+
+void data_buffer::assign_view(nc_type theType, size_type theNelems, void const * p,
+    std::shared_ptr<void const> const & theKeeper, bool reversed) {
+
+    storage.reset();
+
+    type = theType;
+    nelems = theNelems;
+    view = p;
+    keeper = theKeeper;
+
+    // Single byte elements have no byte order to speak of.
+    view_reversed = reversed && get_element_size(theType) > 1;
+}
+
+bool data_buffer::is_view() const {
+    return view != nullptr;
+}
+
+bool data_buffer::is_host_order() const {
+    return !view || !view_reversed;
+}
+
+void data_buffer::materialize() {
+
+    if (!view) return;
+
+    const auto size = size_in_bytes();
+
+    std::unique_ptr<void, aligned_deleter> block(aligned_allocate(size, alignment));
+
+    if (view_reversed)
+        swap_endian_array(block.get(), view, get_element_size(type), nelems);
+    else if (size)
+        memcpy(block.get(), view, size);
+
+    storage = std::move(block);
+    view = nullptr;
+    keeper.reset();
+    view_reversed = false;
+}
+
+void * data_buffer::data() {
+
+    if (view)
+        throw std::logic_error("view is read-only; materialize it first");
+
+    return storage.get();
+}
+
+void const * data_buffer::data() const {
+
+    if (!is_host_order())
+        throw std::logic_error("view is not in host byte order; materialize it first");
+
+    return bytes();
+}
+
+void const * data_buffer::bytes() const {
+    return view ? view : storage.get();
+}
+
+data_buffer::size_type data_buffer::get_element_size(nc_type theType) {
+    return theType == nc_char ? sizeof(char) : get_primitive_value_size(theType);
+}
@@ -0,0 +1,153 @@
+#ifndef NETCDF_DATA_BUFFER_H
+#define NETCDF_DATA_BUFFER_H
+
+#pragma once
+
+#include "enums.h"
+#include "utils.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Variable data lives in one contiguous, aligned block of natively typed elements, instead of
+one value per element. The block is exactly nelems times the element size, which is to say the
+same size as the data on disk less any padding, and may be handed to numeric code as-is.
+
+The buffer may also be a view of data owned elsewhere, i.e. a file mapping, kept alive for as
+long as the view is. Views are read-only, and are never copied behind the caller's back: asking
+for mutable data of a view, or for the elements of a view whose byte order still needs reversing,
+throws, short of materialize, which makes the copy, once, when asked. The bytes of any buffer may
+be had as they are, whatever their byte order. Views are only as aligned as the data they refer to. */
+struct data_buffer {
+
+    typedef std::size_t size_type;
+
+    // Wide enough for the widest vector registers we are likely to hand the data to.
+    static const size_type alignment = 32;
+
+    data_buffer();
+    data_buffer(nc_type aType, size_type nelems);
+    data_buffer(data_buffer const & other);
+    data_buffer(data_buffer && other) noexcept;
+
+    data_buffer & operator=(data_buffer const & other);
+    data_buffer & operator=(data_buffer && other) noexcept;
+
+    nc_type get_type() const;
+
+    size_type size() const;
+    size_type size_in_bytes() const;
+
+    bool empty() const;
+
+    // (Re-)allocates the block for nelems elements of the type, zero filled.
+    void assign(nc_type aType, size_type nelems);
+
+    // As assign, but the elements are left as they are, for when they are about to be read over.
+    void assign_uninitialized(nc_type aType, size_type nelems);
+
+    void clear();
+
+    /* Refers to nelems elements at p, owned elsewhere and kept alive by the keeper, rather than
+    copying them. Reversed data is put in host byte order when it is first accessed. */
+    void assign_view(nc_type aType, size_type nelems, void const * p,
+        std::shared_ptr<void const> const & keeper, bool reversed);
+
+    bool is_view() const;
+
+    // Whether the elements are in host byte order, i.e. may be had as their type; only a view may not be.
+    bool is_host_order() const;
+
+    // Copies the viewed data, if any, into a block of its own, in host byte order.
+    void materialize();
+
+    // The elements, which a view, being read-only, has none of; see materialize.
+    void * data();
+
+    // The elements, as they are, never copied; throws for a view not yet in host byte order.
+    void const * data() const;
+
+    // The bytes as they are held, in host byte order or not, for when they are only to be moved along.
+    void const * bytes() const;
+
+    template<typename _Ty>
+    _Ty * data_as() {
+        assert(is_data_type<_Ty>());
+        return static_cast<_Ty *>(data());
+    }
+
+    template<typename _Ty>
+    _Ty const * data_as() const {
+        assert(is_data_type<_Ty>());
+        return static_cast<_Ty const *>(data());
+    }
+
+    template<typename _Ty>
+    _Ty & at(size_type i) {
+        assert(i < nelems);
+        return data_as<_Ty>()[i];
+    }
+
+    template<typename _Ty>
+    _Ty const & at(size_type i) const {
+        assert(i < nelems);
+        return data_as<_Ty>()[i];
+    }
+
+    template<class _Vector>
+    void set_values(_Vector const & theValues) {
+
+        nc_type theType;
+
+        //TODO: TBD: may throw an exception here instead...
+        if (!try_get_type_for<typename _Vector::value_type>(theType))
+            return;
+
+        assign(theType, theValues.size());
+
+        auto p = data_as<typename _Vector::value_type>();
+
+        for (auto const & x : theValues)
+            *p++ = x;
+    }
+
+    template<class _Vector>
+    _Vector get_values() const {
+        auto p = data_as<typename _Vector::value_type>();
+        return _Vector(p, p + nelems);
+    }
+
+    // Text (nc_char) data is one byte per element, otherwise the size of the primitive type.
+    static size_type get_element_size(nc_type aType);
+
+    // Whether the elements may be had as _Ty, i.e. by data_as.
+    template<typename _Ty>
+    bool is_data_type() const {
+        return type == get_type_for<_Ty>()
+            || (type == nc_char && sizeof(_Ty) == sizeof(char))
+            || (type == nc_ubyte && get_type_for<_Ty>() == nc_byte);
+    }
+
+private:
+
+    struct aligned_deleter {
+        void operator()(void * p) const;
+    };
+
+    nc_type type;
+
+    size_type nelems;
+
+    std::unique_ptr<void, aligned_deleter> storage;
+
+    void const * view;
+
+    std::shared_ptr<void const> keeper;
+
+    bool view_reversed;
+};
+
+#endif //NETCDF_DATA_BUFFER_H
@@ -0,0 +1,20 @@
+#include "data_loader.h"
+#include "var.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+data_loader::data_loader() {
+}
+
+data_loader::~data_loader() {
+}
+
+void data_loader::load(var & theVar) {
+    load(theVar, theVar.data);
+}
+
+// Serial, on the caller's thread; the pool is for loaders whose source may be read at once.
+void data_loader::load(std::vector<var *> const & vars, thread_pool &) {
+    for (auto pVar : vars)
+        load(*pVar);
+}
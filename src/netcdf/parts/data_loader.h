@@ -0,0 +1,44 @@
+#ifndef NETCDF_DATA_LOADER_H
+#define NETCDF_DATA_LOADER_H
+
+#pragma once
+
+#include "slab.h"
+#include "thread_pool.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct var;
+struct data_buffer;
+
+/* Knows where a variable's data came from, and how to get it from there, such that the data
+need not be loaded until it is actually wanted. */
+struct data_loader {
+
+    virtual ~data_loader();
+
+    // Loads the data of the var into the var itself.
+    virtual void load(var & aVar);
+
+    /* Loads the data of the var into the given data, leaving the var alone, such that the load may
+    run on another thread while the var is used, or moved, meanwhile; see netcdf::prefetch_var. */
+    virtual void load(var const & aVar, data_buffer & theData) = 0;
+
+    /* Loads each of the vars, spreading the work across the pool where the source allows it, and
+    returns once all of them are loaded. By default they are simply loaded one after another, on
+    the caller's thread, leaving the pool alone; see cdf_loader for a loader that uses it. */
+    virtual void load(std::vector<var *> const & vars, thread_pool & pool);
+
+    /* Reads just the slab of the var into the data, which is already assigned the slab's type
+    and element count. The shape is the var's, along its dimids, including the number of records
+    when it is a record var. */
+    virtual void read_slab(var const & aVar, slab const & aSlab, slab::index_vector const & shape, data_buffer & theData) = 0;
+
+protected:
+
+    data_loader();
+};
+
+#endif //NETCDF_DATA_LOADER_H
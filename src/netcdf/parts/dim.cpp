@@ -1,30 +1,49 @@
-
-#include "dim.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-dim::dim()
-    : named()
-    , dim_length(0) {
-}
-
-dim::dim(std::string const & name, int32_t dim_length)
-    : named(name)
-    , dim_length(dim_length) {
-}
-
-dim::dim(dim const & other)
-    : named(other)
-    , dim_length(other.dim_length) {
-}
-
-dim::~dim() {
-}
-
-bool dim::is_record() const {
-    return !dim_length;
-}
-
-int32_t dim::get_dim_length_part() const {
-    return is_record() ? 1 : dim_length;
-}
+
+#include "dim.h"
+
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+dim::dim()
+    : named()
+    , dim_length(0) {
+}
+
+dim::dim(std::string const & name, int64_t dim_length)
+    : named(name)
+    , dim_length(dim_length) {
+}
+
+dim::dim(dim const & other)
+    : named(other)
+    , dim_length(other.dim_length) {
+}
+
+dim::dim(dim && other) noexcept
+    : named(std::move(other))
+    , dim_length(other.dim_length) {
+}
+
+dim & dim::operator=(dim const & other) {
+    named::operator=(other);
+    dim_length = other.dim_length;
+    return *this;
+}
+
+dim & dim::operator=(dim && other) noexcept {
+    named::operator=(std::move(other));
+    dim_length = other.dim_length;
+    return *this;
+}
+
+dim::~dim() {
+}
+
+bool dim::is_record() const {
+    return !dim_length;
+}
+
+int64_t dim::get_dim_length_part() const {
+    return is_record() ? 1 : dim_length;
+}
@@ -1,29 +1,33 @@
-#ifndef NETCDF_DIM_H
-#define NETCDF_DIM_H
-
-#pragma once
-
-#include "named.h"
-
-#include <vector>
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct dim : public named {
-    int32_t dim_length;
-    bool is_record() const;
-    int32_t get_dim_length_part() const;
-    dim();
-    dim(dim const & other);
-    virtual ~dim();
-
-private:
-
-    dim(std::string const & name, int32_t dim_length);
-
-    friend struct netcdf;
-};
-
-typedef std::vector<dim> dim_vector;
-
-#endif //NETCDF_DIM_H
+#ifndef NETCDF_DIM_H
+#define NETCDF_DIM_H
+
+#pragma once
+
+#include "named.h"
+#include "arena_allocator.hpp"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct dim : public named {
+    int64_t dim_length;
+    bool is_record() const;
+    int64_t get_dim_length_part() const;
+    dim();
+    dim(dim const & other);
+    dim(dim && other) noexcept;
+    dim & operator=(dim const & other);
+    dim & operator=(dim && other) noexcept;
+    virtual ~dim();
+
+private:
+
+    dim(std::string const & name, int64_t dim_length);
+
+    friend struct netcdf;
+};
+
+typedef std::vector<dim, arena_allocator<dim>> dim_vector;
+
+#endif //NETCDF_DIM_H
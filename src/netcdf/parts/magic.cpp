@@ -1,32 +1,47 @@
-
-#include "magic.h"
-
-#include <memory>
-
-///////////////////////////////////////////////////////////////////////////////
-
-magic::magic()
-    : /*size_reporter()
-      , */version(classic) {
-    init();
-}
-
-magic::magic(magic const & other)
-    : /*size_reporter(other)
-      , */version(other.version) {
-    init();
-}
-
-void magic::init() {
-    // When to (or to not) use auto... auto took some liberties with this.
-    static const char tmp[3] = { 'C', 'D', 'F' };
-    memcpy(&key, &tmp, sizeof(key));
-}
-
-bool magic::is_classic() const {
-    return version == classic;
-}
-
-bool magic::is_x64() const {
-    return version == x64;
-}
+
+#include "magic.h"
+
+#include <cstring>
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+
+magic::magic()
+    : /*size_reporter()
+      , */version(classic) {
+    init();
+}
+
+magic::magic(magic const & other)
+    : /*size_reporter(other)
+      , */version(other.version) {
+    init();
+}
+
+magic & magic::operator=(magic const & other) {
+    // The key is always the same, so there is only the version to take.
+    version = other.version;
+    return *this;
+}
+
+void magic::init() {
+    // When to (or to not) use auto... auto took some liberties with this.
+    static const char tmp[3] = { 'C', 'D', 'F' };
+    memcpy(&key, &tmp, sizeof(key));
+}
+
+bool magic::is_classic() const {
+    return version == classic;
+}
+
+bool magic::is_x64() const {
+    return version == x64;
+}
+
+bool magic::is_x64_data() const {
+    return version == x64_data;
+}
+
+bool magic::has_x64_sizes() const {
+    return is_x64_data();
+}
@@ -1,27 +1,33 @@
-#ifndef NETCDF_MAGIC_H
-#define NETCDF_MAGIC_H
-
-#pragma once
-
-#include "enums.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct magic {
-    typedef char key_type[3];
-    key_type key;
-    cdf_version version;
-
-    magic();
-
-    magic(magic const & other);
-
-    bool is_classic() const;
-    bool is_x64() const;
-
-private:
-
-    void init();
-};
-
-#endif //NETCDF_MAGIC_H
+#ifndef NETCDF_MAGIC_H
+#define NETCDF_MAGIC_H
+
+#pragma once
+
+#include "enums.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct magic {
+    typedef char key_type[3];
+    key_type key;
+    cdf_version version;
+
+    magic();
+
+    magic(magic const & other);
+
+    magic & operator=(magic const & other);
+
+    bool is_classic() const;
+    bool is_x64() const;
+    bool is_x64_data() const;
+
+    // Whether nelems, dim lengths, dimids, vsize and numrecs are INT64, i.e. CDF-5.
+    bool has_x64_sizes() const;
+
+private:
+
+    void init();
+};
+
+#endif //NETCDF_MAGIC_H
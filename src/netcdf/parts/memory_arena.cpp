@@ -0,0 +1,88 @@
+#include "memory_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+///////////////////////////////////////////////////////////////////////////////
+
+memory_arena::memory_arena(size_type block_size)
+    : block_size(std::max<size_type>(block_size, 1024))
+    , blocks(nullptr)
+    , current(nullptr)
+    , end(nullptr)
+    , allocated_size(0)
+    , block_count(0) {
+}
+
+memory_arena::~memory_arena() {
+    release(blocks);
+}
+
+void memory_arena::release(block * first) {
+    while (first) {
+        auto next = first->next;
+        ::operator delete(first);
+        first = next;
+    }
+}
+
+void memory_arena::add_block(size_type nbytes) {
+
+    // Each block is at least twice the last, and large enough for the allocation at hand.
+    const auto size = std::max(blocks ? blocks->size * 2 : block_size, nbytes + sizeof(block));
+
+    auto theBlock = static_cast<block *>(::operator new(size));
+
+    theBlock->next = blocks;
+    theBlock->size = size;
+
+    blocks = theBlock;
+    block_count++;
+
+    current = reinterpret_cast<char *>(theBlock + 1);
+    end = reinterpret_cast<char *>(theBlock) + size;
+}
+
+static char * align_up(char * p, memory_arena::size_type alignment) {
+    const auto x = reinterpret_cast<std::uintptr_t>(p);
+    return reinterpret_cast<char *>((x + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1));
+}
+
+void * memory_arena::allocate(size_type nbytes, size_type alignment) {
+
+    auto p = blocks ? align_up(current, alignment) : nullptr;
+
+    if (!p || p > end || static_cast<size_type>(end - p) < nbytes) {
+        add_block(nbytes + alignment);
+        p = align_up(current, alignment);
+    }
+
+    current = p + nbytes;
+    allocated_size += nbytes;
+
+    return p;
+}
+
+void memory_arena::reset() {
+
+    if (!blocks) return;
+
+    // Keep the latest block, being the largest, and release the ones before it.
+    release(blocks->next);
+
+    blocks->next = nullptr;
+    block_count = 1;
+    allocated_size = 0;
+
+    current = reinterpret_cast<char *>(blocks + 1);
+    end = reinterpret_cast<char *>(blocks) + blocks->size;
+}
+
+memory_arena::size_type memory_arena::get_allocated_size() const {
+    return allocated_size;
+}
+
+memory_arena::size_type memory_arena::get_block_count() const {
+    return block_count;
+}
@@ -0,0 +1,59 @@
+#ifndef NETCDF_MEMORY_ARENA_H
+#define NETCDF_MEMORY_ARENA_H
+
+#pragma once
+
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Hands out memory from a few large blocks, bumping a pointer through each, and gives it all
+back at once, when the arena is reset or goes away; freeing any one allocation does nothing.
+This suits the metadata of a file, i.e. the dims, attrs and vars of its header, which are many
+and small, and which come and go together. Blocks grow, each twice the last, so that however
+large the header, there are only a handful of them.
+
+The arena is not safe to share across threads, and must outlive whatever was allocated from it. */
+struct memory_arena {
+
+    typedef std::size_t size_type;
+
+    memory_arena(size_type block_size = 64 * 1024);
+
+    virtual ~memory_arena();
+
+    void * allocate(size_type nbytes, size_type alignment);
+
+    // Gives back everything allocated so far, keeping the largest block for whatever comes next.
+    void reset();
+
+    // The bytes handed out, and the blocks they came from, since the arena was last reset.
+    size_type get_allocated_size() const;
+    size_type get_block_count() const;
+
+private:
+
+    memory_arena(memory_arena const &) {}
+
+    struct block {
+        block * next;
+        size_type size;
+    };
+
+    void add_block(size_type nbytes);
+
+    void release(block * first);
+
+    size_type block_size;
+
+    // The most recent block, which is the one being handed out, followed by the ones before it.
+    block * blocks;
+
+    char * current;
+    char * end;
+
+    size_type allocated_size;
+    size_type block_count;
+};
+
+#endif //NETCDF_MEMORY_ARENA_H
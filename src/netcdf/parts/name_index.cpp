@@ -0,0 +1,81 @@
+#include "name_index.h"
+
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+const name_index::size_type name_index::linear_limit;
+
+name_index::name_index()
+    : positions()
+    , indexed_size(0)
+    , reserved(0)
+    , rebuilds(0) {
+}
+
+name_index::name_index(name_index const & other)
+    : positions(other.positions)
+    , indexed_size(other.indexed_size)
+    , reserved(other.reserved)
+    , rebuilds(0) {
+}
+
+name_index::name_index(name_index && other) noexcept
+    : positions(std::move(other.positions))
+    , indexed_size(other.indexed_size)
+    , reserved(other.reserved)
+    , rebuilds(0) {
+    other.indexed_size = 0;
+}
+
+name_index & name_index::operator=(name_index const & other) {
+    positions = other.positions;
+    indexed_size = other.indexed_size;
+    reserved = other.reserved;
+    return *this;
+}
+
+name_index & name_index::operator=(name_index && other) noexcept {
+    positions = std::move(other.positions);
+    indexed_size = other.indexed_size;
+    reserved = other.reserved;
+    other.indexed_size = 0;
+    return *this;
+}
+
+name_index::~name_index() {
+}
+
+void name_index::clear() {
+    positions.clear();
+    indexed_size = 0;
+}
+
+void name_index::reserve(size_type n) {
+    reserved = n;
+
+    // Short of an index, there is nothing to make room in yet; see rebuild.
+    if (indexed_size)
+        positions.reserve(n);
+}
+
+name_index::size_type name_index::get_rebuild_count() const {
+    return rebuilds;
+}
+
+bool name_index::try_get(std::string const & name, size_type & i) const {
+
+    auto it = positions.find(name);
+
+    if (it == positions.end())
+        return false;
+
+    i = it->second;
+
+    return true;
+}
+
+void name_index::add(std::string const & name, size_type i) {
+    positions.emplace(name, i);
+    indexed_size++;
+}
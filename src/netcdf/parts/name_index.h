@@ -0,0 +1,116 @@
+#ifndef NETCDF_NAME_INDEX_H
+#define NETCDF_NAME_INDEX_H
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Maps the names of the items of a vector, i.e. dims, vars or attrs, to their positions. The
+vectors are public, and may be changed behind the index's back, so the index is checked on the
+way out, as far as that costs nothing: it is rebuilt whenever the size no longer agrees, or the
+item found goes by another name. A miss is taken at its word, such that the duplicate check of
+every add stays O(1); items renamed, or replaced at the same size, call for a reindex.
+
+A few items are simply searched, which is as quick as hashing the name, and allocates nothing; the
+index is only built once there are more than that, and then only when a name is looked up. */
+struct name_index {
+
+    typedef std::size_t size_type;
+
+    static const size_type linear_limit = 32;
+
+    name_index();
+    name_index(name_index const & other);
+    name_index(name_index && other) noexcept;
+
+    name_index & operator=(name_index const & other);
+    name_index & operator=(name_index && other) noexcept;
+
+    virtual ~name_index();
+
+    template<class _Vector>
+    typename _Vector::iterator find(_Vector & items, std::string const & name) {
+
+        if (items.size() <= linear_limit) {
+            return std::find_if(items.begin(), items.end(),
+                [&](typename _Vector::value_type const & x) { return x.name == name; });
+        }
+
+        size_type i = 0;
+
+        if (indexed_size == items.size()) {
+
+            if (!try_get(name, i))
+                return items.end();
+
+            if (items[i].name == name)
+                return items.begin() + i;
+        }
+
+        rebuild(items);
+
+        return try_get(name, i) ? items.begin() + i : items.end();
+    }
+
+    /* Takes note of the item just inserted, which is cheap when it went at the end. Short of an
+    index, i.e. while there are few items, or until a name is looked up, there is nothing to do. */
+    template<class _Vector>
+    void inserted(_Vector const & items, typename _Vector::const_iterator it) {
+
+        if (!indexed_size) return;
+
+        if (indexed_size + 1 == items.size() && it + 1 == items.end()) {
+            add(it->name, items.size() - 1);
+            return;
+        }
+
+        rebuild(items);
+    }
+
+    // Duplicate names, which the format does not allow, resolve to the first of them.
+    template<class _Vector>
+    void rebuild(_Vector const & items) {
+
+        clear();
+
+        rebuilds++;
+
+        positions.reserve(std::max<size_type>(items.size(), reserved));
+
+        for (size_type i = 0; i < items.size(); i++)
+            positions.emplace(items[i].name, i);
+
+        indexed_size = items.size();
+    }
+
+    // Drops the index, leaving it to be rebuilt the next time a name is looked up.
+    void clear();
+
+    /* Makes room for as many names, such that adding them up to there does not rehash, and the
+    index is built that large when built later. */
+    void reserve(size_type n);
+
+    // How many times the items have been walked to build the index, i.e. what adding is meant to avoid.
+    size_type get_rebuild_count() const;
+
+private:
+
+    std::unordered_map<std::string, size_type> positions;
+
+    size_type indexed_size;
+
+    size_type reserved;
+
+    size_type rebuilds;
+
+    bool try_get(std::string const & name, size_type & i) const;
+
+    void add(std::string const & name, size_type i);
+};
+
+#endif //NETCDF_NAME_INDEX_H
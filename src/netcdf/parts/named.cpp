@@ -1,21 +1,37 @@
-#include "named.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-named::named() {
-}
-
-named::named(std::string const & name)
-    : name(name) {
-}
-
-named::named(named const & other)
-    : name(other.name) {
-}
-
-named::~named() {
-}
-
-int32_t named::get_name_length() const {
-    return static_cast<int32_t>(name.size());
-}
+#include "named.h"
+
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+named::named() {
+}
+
+named::named(std::string const & name)
+    : name(name) {
+}
+
+named::named(named const & other)
+    : name(other.name) {
+}
+
+named::named(named && other) noexcept
+    : name(std::move(other.name)) {
+}
+
+named & named::operator=(named const & other) {
+    name = other.name;
+    return *this;
+}
+
+named & named::operator=(named && other) noexcept {
+    name = std::move(other.name);
+    return *this;
+}
+
+named::~named() {
+}
+
+int32_t named::get_name_length() const {
+    return static_cast<int32_t>(name.size());
+}
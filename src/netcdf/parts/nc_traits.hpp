@@ -0,0 +1,77 @@
+#ifndef NETCDF_NC_TRAITS_H
+#define NETCDF_NC_TRAITS_H
+
+#pragma once
+
+#include "enums.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Associates each primitive nc_type with its C++ type, and vice versa, at compile time: the
+size of an element, and whether its byte order needs reversing on the way to or from the file,
+follow from the type. nc_char is the odd one out, being text, i.e. one char per element. */
+template<nc_type _Type, typename _Ty>
+struct nc_primitive_traits {
+    typedef _Ty value_type;
+    static constexpr nc_type type = _Type;
+    static constexpr std::size_t size = sizeof(_Ty);
+    static constexpr bool needs_swap = sizeof(_Ty) > 1;
+};
+
+template<nc_type _Type>
+struct nc_type_traits;
+
+template<> struct nc_type_traits<nc_byte> : nc_primitive_traits<nc_byte, uint8_t> {};
+template<> struct nc_type_traits<nc_char> : nc_primitive_traits<nc_char, char> {};
+template<> struct nc_type_traits<nc_short> : nc_primitive_traits<nc_short, int16_t> {};
+template<> struct nc_type_traits<nc_int> : nc_primitive_traits<nc_int, int32_t> {};
+template<> struct nc_type_traits<nc_float> : nc_primitive_traits<nc_float, float> {};
+template<> struct nc_type_traits<nc_double> : nc_primitive_traits<nc_double, double> {};
+template<> struct nc_type_traits<nc_ubyte> : nc_primitive_traits<nc_ubyte, uint8_t> {};
+template<> struct nc_type_traits<nc_ushort> : nc_primitive_traits<nc_ushort, uint16_t> {};
+template<> struct nc_type_traits<nc_uint> : nc_primitive_traits<nc_uint, uint32_t> {};
+template<> struct nc_type_traits<nc_int64> : nc_primitive_traits<nc_int64, int64_t> {};
+template<> struct nc_type_traits<nc_uint64> : nc_primitive_traits<nc_uint64, uint64_t> {};
+
+// The nc_type for a C++ type, nc_absent when there is none; uint8_t is taken to be nc_byte.
+template<typename _Ty>
+struct nc_type_of : std::integral_constant<nc_type, nc_absent> {};
+
+template<> struct nc_type_of<uint8_t> : std::integral_constant<nc_type, nc_byte> {};
+template<> struct nc_type_of<int16_t> : std::integral_constant<nc_type, nc_short> {};
+template<> struct nc_type_of<int32_t> : std::integral_constant<nc_type, nc_int> {};
+template<> struct nc_type_of<float> : std::integral_constant<nc_type, nc_float> {};
+template<> struct nc_type_of<double> : std::integral_constant<nc_type, nc_double> {};
+template<> struct nc_type_of<uint16_t> : std::integral_constant<nc_type, nc_ushort> {};
+template<> struct nc_type_of<uint32_t> : std::integral_constant<nc_type, nc_uint> {};
+template<> struct nc_type_of<int64_t> : std::integral_constant<nc_type, nc_int64> {};
+template<> struct nc_type_of<uint64_t> : std::integral_constant<nc_type, nc_uint64> {};
+
+/* Calls the function with a value of the C++ type of the primitive nc_type, i.e. func(int16_t())
+for nc_short, such that a generic kernel is instantiated once per type, and the type is switched
+on once per array rather than once per element. Throws for types that are not primitive. */
+template<typename _Function>
+auto dispatch_primitive(nc_type type, _Function && func) -> decltype(func(uint8_t())) {
+
+    switch (type) {
+    case nc_byte: return func(nc_type_traits<nc_byte>::value_type());
+    case nc_short: return func(nc_type_traits<nc_short>::value_type());
+    case nc_int: return func(nc_type_traits<nc_int>::value_type());
+    case nc_float: return func(nc_type_traits<nc_float>::value_type());
+    case nc_double: return func(nc_type_traits<nc_double>::value_type());
+    case nc_ubyte: return func(nc_type_traits<nc_ubyte>::value_type());
+    case nc_ushort: return func(nc_type_traits<nc_ushort>::value_type());
+    case nc_uint: return func(nc_type_traits<nc_uint>::value_type());
+    case nc_int64: return func(nc_type_traits<nc_int64>::value_type());
+    case nc_uint64: return func(nc_type_traits<nc_uint64>::value_type());
+    default: break;
+    }
+
+    throw std::runtime_error("unsupported nc_type");
+}
+
+#endif //NETCDF_NC_TRAITS_H
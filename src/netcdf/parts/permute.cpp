@@ -0,0 +1,224 @@
+#include "permute.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+///////////////////////////////////////////////////////////////////////////////
+
+typedef slab::index_vector index_vector;
+
+/* How the elements of src land in dest: the dim innermost in src, i, and the one innermost in
+dest, j, along with the other, outer, dims. Offsets and strides are in elements. */
+struct permutation {
+
+    // Elements along the edge of a tile, i.e. a tile of four byte elements is 16 KiB.
+    static const int64_t tile = 64;
+
+    // The innermost dims of src and of dest, each as a dim of src.
+    index_vector::size_type i;
+    index_vector::size_type j;
+
+    int64_t length_i;
+    int64_t length_j;
+
+    // The stride of j in src, and of i in dest; the other two are one.
+    int64_t src_stride_j;
+    int64_t dest_stride_i;
+
+    // The outer dims, outermost first, with their strides in src and dest.
+    index_vector outer_lengths;
+    index_vector outer_src_strides;
+    index_vector outer_dest_strides;
+
+    int64_t outer_count;
+
+    // The units of work: a run per outer index, or a band of tile rows of dest when i and j differ.
+    int64_t bands;
+    int64_t units;
+
+    permutation(index_vector const & shape, axis_vector const & axes) {
+
+        const auto rank = shape.size();
+
+        index_vector src_strides(rank, 1);
+        index_vector dest_strides_of_src(rank, 1);
+
+        for (auto d = rank; d > 1; d--)
+            src_strides[d - 2] = src_strides[d - 1] * shape[d - 1];
+
+        int64_t stride = 1;
+
+        for (auto d = rank; d > 0; d--) {
+            dest_strides_of_src[axes[d - 1]] = stride;
+            stride *= shape[axes[d - 1]];
+        }
+
+        i = rank - 1;
+        j = axes[rank - 1];
+
+        length_i = shape[i];
+        length_j = shape[j];
+
+        src_stride_j = src_strides[j];
+        dest_stride_i = dest_strides_of_src[i];
+
+        outer_count = 1;
+
+        for (index_vector::size_type d = 0; d < rank; d++) {
+            if (d == i || d == j) continue;
+            outer_lengths.push_back(shape[d]);
+            outer_src_strides.push_back(src_strides[d]);
+            outer_dest_strides.push_back(dest_strides_of_src[d]);
+            outer_count *= shape[d];
+        }
+
+        bands = i == j ? 1 : (length_i + tile - 1) / tile;
+        units = outer_count * bands;
+    }
+
+    void get_outer_offsets(int64_t o, int64_t & src_offset, int64_t & dest_offset) const {
+
+        src_offset = dest_offset = 0;
+
+        for (auto d = outer_lengths.size(); d > 0; d--) {
+            const auto k = o % outer_lengths[d - 1];
+            o /= outer_lengths[d - 1];
+            src_offset += k * outer_src_strides[d - 1];
+            dest_offset += k * outer_dest_strides[d - 1];
+        }
+    }
+
+    template<typename _Element>
+    void run(_Element const * src, _Element * dest, int64_t first, int64_t last) const {
+
+        for (auto u = first; u < last; u++) {
+
+            int64_t src_offset, dest_offset;
+
+            get_outer_offsets(u / bands, src_offset, dest_offset);
+
+            // The innermost dim stays innermost, so the run is contiguous in both.
+            if (i == j) {
+                std::memcpy(dest + dest_offset, src + src_offset, static_cast<std::size_t>(length_i) * sizeof(_Element));
+                continue;
+            }
+
+            const auto band_begin = (u % bands) * tile;
+            const auto band_end = std::min(band_begin + tile, length_i);
+
+            // Tile by tile across the band, each row of dest within the tile written contiguously.
+            for (int64_t jb = 0; jb < length_j; jb += tile) {
+
+                const auto n = std::min(tile, length_j - jb);
+
+                for (auto ii = band_begin; ii < band_end; ii++) {
+
+                    auto s = src + src_offset + ii + jb * src_stride_j;
+                    auto d = dest + dest_offset + ii * dest_stride_i + jb;
+
+                    for (int64_t jj = 0; jj < n; jj++)
+                        d[jj] = s[jj * src_stride_j];
+                }
+            }
+        }
+    }
+
+    void run(void const * src, void * dest, std::size_t width, int64_t first, int64_t last) const {
+        switch (width) {
+        case 1: run(static_cast<uint8_t const *>(src), static_cast<uint8_t *>(dest), first, last); break;
+        case 2: run(static_cast<uint16_t const *>(src), static_cast<uint16_t *>(dest), first, last); break;
+        case 4: run(static_cast<uint32_t const *>(src), static_cast<uint32_t *>(dest), first, last); break;
+        case 8: run(static_cast<uint64_t const *>(src), static_cast<uint64_t *>(dest), first, last); break;
+        default: throw std::invalid_argument("unsupported element width");
+        }
+    }
+};
+
+void validate_axes(axis_vector const & axes, axis_vector::size_type rank) {
+
+    if (axes.size() != rank)
+        throw std::invalid_argument("axes do not match rank");
+
+    std::vector<bool> seen(rank, false);
+
+    for (auto & axis : axes) {
+        if (axis >= rank || seen[axis])
+            throw std::invalid_argument("axes are not a permutation");
+        seen[axis] = true;
+    }
+}
+
+// Copies arrays that are not permuted at all, or are empty, in one go; returns whether it did.
+static bool try_copy_whole(void const * src, void * dest, std::size_t width,
+    index_vector const & shape, axis_vector const & axes) {
+
+    validate_axes(axes, shape.size());
+
+    int64_t nelems = 1;
+
+    for (auto & n : shape)
+        nelems *= n;
+
+    bool identity = true;
+
+    for (axis_vector::size_type d = 0; d < axes.size(); d++)
+        identity = identity && axes[d] == d;
+
+    if (!identity && nelems)
+        return false;
+
+    if (nelems)
+        std::memcpy(dest, src, static_cast<std::size_t>(nelems) * width);
+
+    return true;
+}
+
+void permute_elements(void const * src, void * dest, std::size_t width,
+    index_vector const & shape, axis_vector const & axes) {
+
+    if (try_copy_whole(src, dest, width, shape, axes)) return;
+
+    const permutation thePermutation(shape, axes);
+
+    thePermutation.run(src, dest, width, 0, thePermutation.units);
+}
+
+void permute_elements(void const * src, void * dest, std::size_t width,
+    index_vector const & shape, axis_vector const & axes, thread_pool & pool) {
+
+    if (try_copy_whole(src, dest, width, shape, axes)) return;
+
+    const permutation thePermutation(shape, axes);
+
+    const auto units = thePermutation.units;
+
+    int64_t nelems = 1;
+
+    for (auto & n : shape)
+        nelems *= n;
+
+    // Small enough to be done before the pool would get going.
+    const int64_t min_bytes = 1024 * 1024;
+
+    const auto ntasks = std::min<int64_t>(units, static_cast<int64_t>(pool.size()) * 4);
+
+    if (ntasks < 2 || nelems * static_cast<int64_t>(width) < min_bytes) {
+        thePermutation.run(src, dest, width, 0, units);
+        return;
+    }
+
+    thread_pool::batch tasks(pool);
+
+    // Each task writes rows of dest no other task does.
+    for (int64_t t = 0; t < ntasks; t++) {
+
+        const auto first = units * t / ntasks;
+        const auto last = units * (t + 1) / ntasks;
+
+        tasks.submit([=, &thePermutation]() { thePermutation.run(src, dest, width, first, last); });
+    }
+
+    tasks.wait();
+}
@@ -0,0 +1,31 @@
+#ifndef NETCDF_PERMUTE_H
+#define NETCDF_PERMUTE_H
+
+#pragma once
+
+#include "slab.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+typedef std::vector<slab::index_vector::size_type> axis_vector;
+
+/* Copies the row-major array of the shape from src to dest with its dims in the order of the
+axes, i.e. dim d of dest is dim axes[d] of src, elements of the width, one, two, four or eight
+bytes, being copied as they are. When the innermost dim stays innermost, the copy is a run at a
+time; otherwise it goes a tile at a time, each tile small enough for the rows it reads from src
+to stay in cache while it is written to dest row by row. Given a pool, the rows of dest are
+spread across it, unless there are too few to be worth it. */
+void permute_elements(void const * src, void * dest, std::size_t width,
+    slab::index_vector const & shape, axis_vector const & axes);
+
+void permute_elements(void const * src, void * dest, std::size_t width,
+    slab::index_vector const & shape, axis_vector const & axes, thread_pool & pool);
+
+// Throws unless the axes are a permutation of the dims of a shape of the rank.
+void validate_axes(axis_vector const & axes, axis_vector::size_type rank);
+
+#endif //NETCDF_PERMUTE_H
@@ -0,0 +1,56 @@
+#include "slab.h"
+
+#include <stdexcept>
+
+///////////////////////////////////////////////////////////////////////////////
+
+slab::slab()
+    : start()
+    , count()
+    , stride() {
+}
+
+slab::slab(index_vector const & start, index_vector const & count)
+    : start(start)
+    , count(count)
+    , stride(start.size(), 1) {
+}
+
+slab::slab(index_vector const & start, index_vector const & count, index_vector const & stride)
+    : start(start)
+    , count(count)
+    , stride(stride) {
+}
+
+slab::slab(slab const & other)
+    : start(other.start)
+    , count(other.count)
+    , stride(other.stride) {
+}
+
+int64_t slab::get_nelems() const {
+
+    int64_t result = 1;
+
+    for (auto & n : count)
+        result *= n;
+
+    return result;
+}
+
+void slab::validate(index_vector const & shape) const {
+
+    const auto rank = shape.size();
+
+    if (start.size() != rank || count.size() != rank || stride.size() != rank)
+        throw std::invalid_argument("slab rank does not match the var");
+
+    for (index_vector::size_type i = 0; i < rank; i++) {
+
+        if (start[i] < 0 || count[i] < 0 || stride[i] < 1)
+            throw std::invalid_argument("invalid slab");
+
+        if (count[i] && start[i] + (count[i] - 1) * stride[i] >= shape[i])
+            throw std::out_of_range("slab exceeds the var");
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef NETCDF_SLAB_H
+#define NETCDF_SLAB_H
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Describes an N-dimensional hyperslab of a var: where to start, how many elements to take and
+how far apart they are, along each of the var's dimids, in the same order. The elements of the
+slab are arranged row-major, which is to say the same as the var itself. */
+struct slab {
+
+    typedef std::vector<int64_t> index_vector;
+
+    index_vector start;
+    index_vector count;
+    index_vector stride;
+
+    slab();
+    slab(index_vector const & start, index_vector const & count);
+    slab(index_vector const & start, index_vector const & count, index_vector const & stride);
+    slab(slab const & other);
+
+    int64_t get_nelems() const;
+
+    // Throws when the slab does not fit within the shape, i.e. the dim lengths along the dimids.
+    void validate(index_vector const & shape) const;
+
+    /* Visits each contiguous run of elements in the slab, as (record, offset, slab_offset, nelems),
+    in slab order. Offsets are in elements: the offset of the run within its record, or within the
+    var when it is not a record var, and the offset of the run within the slab. Runs are merged
+    across dims for as long as the inner dims are taken whole. Records are never merged, since
+    record data is not contiguous on disk. */
+    template<typename _Function>
+    void for_each_run(index_vector const & shape, bool is_record, _Function const & func) const {
+
+        const auto rank = shape.size();
+
+        if (!rank) {
+            func(0, 0, 0, 1);
+            return;
+        }
+
+        for (auto & n : count)
+            if (!n) return;
+
+        // The record dimension, when there is one, comes first and is visited separately.
+        const index_vector::size_type first = is_record ? 1 : 0;
+
+        index_vector pitch(rank, 1);
+
+        for (auto i = rank - 1; i > first; i--)
+            pitch[i - 1] = pitch[i] * shape[i];
+
+        // Dims from inner onward are covered by each run.
+        auto inner = rank;
+        int64_t run = 1;
+
+        if (rank > first && stride[rank - 1] == 1) {
+            inner = rank - 1;
+            run = count[inner];
+            while (inner > first && count[inner] == shape[inner] && stride[inner - 1] == 1)
+                run *= count[--inner];
+        }
+
+        index_vector i(inner, 0);
+
+        for (int64_t slab_offset = 0;; slab_offset += run) {
+
+            const auto record = is_record ? start[0] + i[0] * stride[0] : 0;
+
+            int64_t offset = inner < rank ? start[inner] * pitch[inner] : 0;
+
+            for (auto d = first; d < inner; d++)
+                offset += (start[d] + i[d] * stride[d]) * pitch[d];
+
+            func(record, offset, slab_offset, run);
+
+            // Count off the outer dims, innermost first.
+            auto d = inner;
+
+            for (; d > 0; d--) {
+                if (++i[d - 1] < count[d - 1]) break;
+                i[d - 1] = 0;
+            }
+
+            if (!d) return;
+        }
+    }
+};
+
+#endif //NETCDF_SLAB_H
@@ -0,0 +1,190 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+
+thread_pool::thread_pool(size_type nthreads)
+    : threads()
+    , tasks()
+    , mutex()
+    , task_ready()
+    , tasks_done()
+    , pending(0)
+    , first_error()
+    , stopping(false) {
+
+    if (!nthreads)
+        nthreads = std::thread::hardware_concurrency();
+
+    // There is always at least the one, even when the number of cores cannot be told.
+    if (!nthreads)
+        nthreads = 1;
+
+    for (size_type i = 0; i < nthreads; i++)
+        threads.push_back(std::thread([this]() { run(); }));
+}
+
+thread_pool::~thread_pool() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    task_ready.notify_all();
+
+    for (auto & t : threads)
+        t.join();
+}
+
+thread_pool::size_type thread_pool::size() const {
+    return threads.size();
+}
+
+void thread_pool::submit(task_type const & task) {
+    enqueue(task, nullptr);
+}
+
+void thread_pool::enqueue(task_type const & task, batch * owner) {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back({ task, owner });
+        pending++;
+
+        if (owner)
+            owner->pending++;
+    }
+
+    task_ready.notify_one();
+}
+
+void thread_pool::wait() {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    tasks_done.wait(lock, [this]() { return !pending; });
+
+    if (first_error) {
+        auto error = first_error;
+        first_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void thread_pool::run() {
+
+    for (;;) {
+
+        queued_task task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            task_ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+            // Whatever is still queued is run before stopping.
+            if (tasks.empty()) return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        run_task(task);
+    }
+}
+
+void thread_pool::run_task(queued_task & task) {
+
+    std::exception_ptr error;
+
+    try {
+        task.task();
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto & theError = task.owner ? task.owner->first_error : first_error;
+
+        if (error && !theError)
+            theError = error;
+
+        // Waiters on a batch are woken for each of its tasks, everyone else once the pool is idle.
+        const auto batch_done = task.owner && !--task.owner->pending;
+
+        if (!--pending || batch_done)
+            tasks_done.notify_all();
+    }
+}
+
+thread_pool::batch::batch(thread_pool & thePool)
+    : pPool(&thePool)
+    , pending(0)
+    , first_error() {
+}
+
+thread_pool::batch::batch(thread_pool * thePool)
+    : pPool(thePool)
+    , pending(0)
+    , first_error() {
+}
+
+thread_pool::batch::~batch() {
+    wait_all();
+}
+
+void thread_pool::batch::submit(task_type const & task) {
+
+    if (!pPool) {
+        task();
+        return;
+    }
+
+    pPool->enqueue(task, this);
+}
+
+void thread_pool::batch::wait() {
+
+    if (!pPool) return;
+
+    wait_all();
+
+    std::lock_guard<std::mutex> lock(pPool->mutex);
+
+    if (first_error) {
+        auto error = first_error;
+        first_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void thread_pool::batch::wait_all() {
+
+    if (!pPool) return;
+
+    std::unique_lock<std::mutex> lock(pPool->mutex);
+
+    while (pending) {
+
+        auto it = std::find_if(pPool->tasks.begin(), pPool->tasks.end(),
+            [this](queued_task const & x) { return x.owner == this; });
+
+        // The rest of the batch is already running elsewhere, so there is nothing for it but to wait.
+        if (it == pPool->tasks.end()) {
+            pPool->tasks_done.wait(lock);
+            continue;
+        }
+
+        auto task = std::move(*it);
+        pPool->tasks.erase(it);
+
+        lock.unlock();
+        pPool->run_task(task);
+        lock.lock();
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef NETCDF_THREAD_POOL_H
+#define NETCDF_THREAD_POOL_H
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* A fixed set of worker threads that run whatever tasks are submitted to them, in the order they
+were submitted. The pool is meant to be long lived, and shared by whatever work can be spread
+across threads, i.e. loading or writing many variables at once. */
+struct thread_pool {
+
+    typedef std::size_t size_type;
+    typedef std::function<void()> task_type;
+
+    // Starts as many threads as there are cores, unless told otherwise.
+    thread_pool(size_type nthreads = 0);
+
+    virtual ~thread_pool();
+
+    size_type size() const;
+
+    void submit(task_type const & task);
+
+    /* Waits for every task submitted so far, batched or not, then rethrows the first exception any
+    task submitted outside a batch threw. */
+    void wait();
+
+    /* A set of tasks waited for together, apart from whatever else the pool is running meanwhile,
+    i.e. other batches, or prefetches. The first exception any of them throws goes to this batch,
+    and nowhere else. Waiting, the caller runs those still queued itself, such that a batch may be
+    waited for from a task of the same pool. A batch going out of scope waits for its tasks, which
+    may well refer to its caller's locals. */
+    struct batch {
+
+        batch(thread_pool & pool);
+
+        // Short of a pool, each task is run there and then, on the caller's thread, throwing straight through.
+        batch(thread_pool * pPool);
+
+        virtual ~batch();
+
+        void submit(task_type const & task);
+
+        // Waits for every task of the batch, then rethrows the first exception any of them threw.
+        void wait();
+
+    private:
+
+        friend struct thread_pool;
+
+        batch(batch const & other);
+
+        void wait_all();
+
+        thread_pool * pPool;
+
+        // Tasks of the batch submitted but not yet finished, whether queued or running.
+        size_type pending;
+
+        std::exception_ptr first_error;
+    };
+
+    /* Runs the function on the pool, returning a future for its result. Whatever it throws goes
+    to the future, and not to wait, which does however wait for it along with everything else. */
+    template<typename _Function>
+    auto async(_Function func) -> std::future<decltype(func())> {
+
+        auto task = std::make_shared<std::packaged_task<decltype(func())()>>(std::move(func));
+
+        auto result = task->get_future();
+
+        submit([task]() { (*task)(); });
+
+        return result;
+    }
+
+private:
+
+    thread_pool(thread_pool const &) {}
+
+    struct queued_task {
+        task_type task;
+        batch * owner;
+    };
+
+    void run();
+
+    void enqueue(task_type const & task, batch * owner);
+
+    // Runs the task on the calling thread, and accounts for it, to its batch if it has one.
+    void run_task(queued_task & task);
+
+    std::vector<std::thread> threads;
+
+    std::deque<queued_task> tasks;
+
+    std::mutex mutex;
+    std::condition_variable task_ready;
+    std::condition_variable tasks_done;
+
+    // Tasks submitted but not yet finished, whether queued or running.
+    size_type pending;
+
+    // The first exception of the tasks submitted outside a batch.
+    std::exception_ptr first_error;
+
+    bool stopping;
+};
+
+#endif //NETCDF_THREAD_POOL_H
@@ -0,0 +1,27 @@
+#include "typed.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+typed::typed(nc_type theType)
+    : type(theType) {
+}
+
+typed::typed(typed const & other)
+    : type(other.type) {
+}
+
+typed & typed::operator=(typed const & other) {
+    type = other.type;
+    return *this;
+}
+
+typed::~typed() {
+}
+
+nc_type typed::get_type() const {
+    return type;
+}
+
+void typed::set_type(nc_type const & theType) {
+    type = theType;
+}
@@ -0,0 +1,27 @@
+#ifndef NETCDF_TYPED_H
+#define NETCDF_TYPED_H
+
+#pragma once
+
+#include "enums.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct typed {
+
+    nc_type type;
+
+    virtual nc_type get_type() const;
+    void set_type(nc_type const & aType);
+
+    virtual ~typed();
+
+protected:
+
+    typed(nc_type aType = nc_absent);
+    typed(typed const & other);
+
+    typed & operator=(typed const & other);
+};
+
+#endif //NETCDF_TYPED_H
@@ -1,24 +1,35 @@
-#include "valuable.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-valuable::valuable(nc_type theType)
-    : type(theType)
-    , values() {
-}
-
-valuable::valuable(valuable const & other)
-    : type(other.type)
-    , values(other.values) {
-}
-
-valuable::~valuable() {
-}
-
-nc_type valuable::get_type() const {
-    return type;
-}
-
-void valuable::set_type(nc_type const & theType) {
-    type = theType;
-}
+#include "valuable.h"
+
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+valuable::valuable(nc_type theType)
+    : typed(theType)
+    , values() {
+}
+
+valuable::valuable(valuable const & other)
+    : typed(other)
+    , values(other.values) {
+}
+
+valuable::valuable(valuable && other) noexcept
+    : typed(other)
+    , values(std::move(other.values)) {
+}
+
+valuable & valuable::operator=(valuable const & other) {
+    typed::operator=(other);
+    values = other.values;
+    return *this;
+}
+
+valuable & valuable::operator=(valuable && other) noexcept {
+    typed::operator=(other);
+    values = std::move(other.values);
+    return *this;
+}
+
+valuable::~valuable() {
+}
@@ -1,49 +1,94 @@
-#include "value.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-value::value() {
-    init();
-}
-
-value::value(uint8_t x) {
-    init();
-    primitive.b = x;
-}
-
-value::value(int16_t x) {
-    init();
-    primitive.s = x;
-}
-
-value::value(int32_t x) {
-    init();
-    primitive.i = x;
-}
-
-value::value(float_t x) {
-    init();
-    primitive.f = x;
-}
-
-value::value(double_t x) {
-    init();
-    primitive.d = x;
-}
-
-value::value(std::string const & text) {
-    init(text);
-}
-
-value::value(value const & other)
-    : primitive(other.primitive)
-    , text(other.text) {
-}
-
-value::~value() {
-}
-
-void value::init(std::string const & text) {
-    this->text = text;
-    memset(&primitive, 0, sizeof(primitive));
-}
+#include "value.h"
+
+#include <cstring>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+value::value() {
+    init();
+}
+
+value::value(uint8_t x) {
+    init();
+    primitive.b = x;
+}
+
+value::value(int16_t x) {
+    init();
+    primitive.s = x;
+}
+
+value::value(int32_t x) {
+    init();
+    primitive.i = x;
+}
+
+value::value(float_t x) {
+    init();
+    primitive.f = x;
+}
+
+value::value(double_t x) {
+    init();
+    primitive.d = x;
+}
+
+value::value(uint16_t x) {
+    init();
+    primitive.us = x;
+}
+
+value::value(uint32_t x) {
+    init();
+    primitive.ui = x;
+}
+
+value::value(int64_t x) {
+    init();
+    primitive.i64 = x;
+}
+
+value::value(uint64_t x) {
+    init();
+    primitive.ui64 = x;
+}
+
+value::value(std::string const & text)
+    : text(text) {
+    init();
+}
+
+value::value(std::string && text)
+    : text(std::move(text)) {
+    init();
+}
+
+value::value(value const & other)
+    : primitive(other.primitive)
+    , text(other.text) {
+}
+
+value::value(value && other) noexcept
+    : primitive(other.primitive)
+    , text(std::move(other.text)) {
+}
+
+value & value::operator=(value const & other) {
+    primitive = other.primitive;
+    text = other.text;
+    return *this;
+}
+
+value & value::operator=(value && other) noexcept {
+    primitive = other.primitive;
+    text = std::move(other.text);
+    return *this;
+}
+
+value::~value() {
+}
+
+void value::init() {
+    memset(&primitive, 0, sizeof(primitive));
+}
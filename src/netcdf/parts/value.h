@@ -1,50 +1,82 @@
-#ifndef NETCDF_VALUE_H
-#define NETCDF_VALUE_H
-
-#pragma once
-
-#include <cstdint>
-#include <string>
-#include <vector>
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct valuable;
-
-struct value {
-    /* This is generally ill advised having a union hanging out here without a closely
-    adjoined type selector, but for file format purposes, this is just fine, since the
-    scope of that decision is slightly beyond the scope of the values themselves. */
-    union {
-        uint8_t b;
-        int16_t s;
-        int32_t i;
-        float_t f;
-        double_t d;
-    } primitive;
-
-    std::string text;
-
-    value();
-    value(std::string const & text);
-    value(value const & other);
-
-    virtual ~value();
-
-private:
-
-    void init(std::string const & text = "");
-
-    //TODO: should these be more exposed: i.e. for writer/reader purposes?
-    value(uint8_t x);
-    value(int16_t x);
-    value(int32_t x);
-    value(float_t x);
-    value(double_t x);
-
-    friend struct valuable;
-};
-
-typedef std::vector<value> value_vector;
-
-#endif //NETCDF_VALUE_H
+#ifndef NETCDF_VALUE_H
+#define NETCDF_VALUE_H
+
+#pragma once
+
+#include "arena_allocator.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct valuable;
+
+struct value {
+    /* This is generally ill advised having a union hanging out here without a closely
+    adjoined type selector, but for file format purposes, this is just fine, since the
+    scope of that decision is slightly beyond the scope of the values themselves. */
+    union {
+        uint8_t b;
+        int16_t s;
+        int32_t i;
+        float_t f;
+        double_t d;
+        uint16_t us;
+        uint32_t ui;
+        int64_t i64;
+        uint64_t ui64;
+    } primitive;
+
+    std::string text;
+
+    value();
+    value(std::string const & text);
+    value(std::string && text);
+    value(value const & other);
+    value(value && other) noexcept;
+
+    value & operator=(value const & other);
+    value & operator=(value && other) noexcept;
+
+    virtual ~value();
+
+    // The primitive as the C++ type of its nc_type; see nc_type_traits.
+    template<typename _Ty>
+    _Ty get() const {
+        static_assert(sizeof(_Ty) <= sizeof(primitive), "not a primitive type");
+        _Ty x;
+        std::memcpy(&x, &primitive, sizeof(x));
+        return x;
+    }
+
+    template<typename _Ty>
+    void set(_Ty x) {
+        static_assert(sizeof(_Ty) <= sizeof(primitive), "not a primitive type");
+        std::memcpy(&primitive, &x, sizeof(x));
+    }
+
+private:
+
+    void init();
+
+    //TODO: should these be more exposed: i.e. for writer/reader purposes?
+    value(uint8_t x);
+    value(int16_t x);
+    value(int32_t x);
+    value(float_t x);
+    value(double_t x);
+    value(uint16_t x);
+    value(uint32_t x);
+    value(int64_t x);
+    value(uint64_t x);
+
+    friend struct valuable;
+};
+
+typedef std::vector<value, arena_allocator<value>> value_vector;
+
+#endif //NETCDF_VALUE_H
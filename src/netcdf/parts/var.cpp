@@ -1,80 +1,223 @@
-
-#include "var.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-//TODO: TBD: methinks that an enumerated rank holds little to no (less, at any rate) value for what is basically an open ended thing...
-enum rank : int32_t {
-    rank_dim_scalar = 0,
-    rank_dim_vector = 1,
-    rank_dim_matrix = 2,
-    //TODO: TBD: others?
-};
-
-///////////////////////////////////////////////////////////////////////////////
-
-var::var()
-    : named()
-    , attributable()
-    , valuable(nc_double)
-    , dimids()
-    , vsize(0)
-    , offset({ { 0LL } }) {
-}
-
-var::var(std::string const & name, nc_type theType)
-    : named(name)
-    , attributable()
-    , valuable(theType)
-    , dimids()
-    , vsize(0)
-    , offset({ { 0LL } }) {
-}
-
-var::var(var const & other)
-    : named(other)
-    , attributable(other)
-    , valuable(other)
-    , dimids(other.dimids)
-    , vsize(other.vsize)
-    , offset(other.offset) {
-}
-
-var::~var() {
-}
-
-bool var::is_scalar() const {
-    return dimids.size() == rank::rank_dim_scalar;
-}
-
-bool var::is_vector() const {
-    return dimids.size() == rank::rank_dim_vector;
-}
-
-bool var::is_matrix() const {
-    //TODO: or greater?
-    return dimids.size() == rank::rank_dim_matrix;
-}
-
-bool is_scalar(var const & theVar) {
-    return theVar.is_scalar();
-}
-
-bool is_vector(var const & theVar) {
-    return theVar.is_vector();
-}
-
-bool is_matrix(var const & theVar) {
-    return theVar.is_matrix();
-}
-
-bool var::is_record(dim_vector const & dims) const {
-
-    // The record dimension length is zero (0).
-    for (auto & dimid : dimids) {
-        if (dims[dimid].is_record())
-            return true;
-    }
-
-    return false;
-}
+
+#include "var.h"
+
+#include <stdexcept>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+
+//TODO: TBD: methinks that an enumerated rank holds little to no (less, at any rate) value for what is basically an open ended thing...
+enum rank : int32_t {
+    rank_dim_scalar = 0,
+    rank_dim_vector = 1,
+    rank_dim_matrix = 2,
+    //TODO: TBD: others?
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+var::var()
+    : named()
+    , attributable()
+    , typed(nc_double)
+    , dimids()
+    , vsize(0)
+    , offset({ { 0LL } })
+    , data()
+    , loader()
+    , loaded(true)
+    , prefetch()
+    , prefetched() {
+}
+
+var::var(std::string const & name, nc_type theType)
+    : named(name)
+    , attributable()
+    , typed(theType)
+    , dimids()
+    , vsize(0)
+    , offset({ { 0LL } })
+    , data()
+    , loader()
+    , loaded(true)
+    , prefetch()
+    , prefetched() {
+}
+
+var::var(var const & other)
+    : named(other)
+    , attributable(other)
+    , typed(other)
+    , dimids(other.dimids)
+    , vsize(other.vsize)
+    , offset(other.offset)
+    , data(other.data)
+    , loader(other.loader)
+    , loaded(other.loaded)
+    , prefetch()
+    , prefetched() {
+}
+
+var::var(var && other) noexcept
+    : named(std::move(other))
+    , attributable(std::move(other))
+    , typed(other)
+    , dimids(std::move(other.dimids))
+    , vsize(other.vsize)
+    , offset(other.offset)
+    , data(std::move(other.data))
+    , loader(std::move(other.loader))
+    , loaded(other.loaded)
+    , prefetch(std::move(other.prefetch))
+    , prefetched(std::move(other.prefetched)) {
+}
+
+var & var::operator=(var const & other) {
+    named::operator=(other);
+    attributable::operator=(other);
+    typed::operator=(other);
+    dimids = other.dimids;
+    vsize = other.vsize;
+    offset = other.offset;
+    data = other.data;
+    loader = other.loader;
+    loaded = other.loaded;
+    prefetch = std::shared_future<void>();
+    prefetched.reset();
+    return *this;
+}
+
+var & var::operator=(var && other) noexcept {
+    named::operator=(std::move(other));
+    attributable::operator=(std::move(other));
+    typed::operator=(other);
+    dimids = std::move(other.dimids);
+    vsize = other.vsize;
+    offset = other.offset;
+    data = std::move(other.data);
+    loader = std::move(other.loader);
+    loaded = other.loaded;
+    prefetch = std::move(other.prefetch);
+    prefetched = std::move(other.prefetched);
+    return *this;
+}
+
+var::~var() {
+}
+
+bool var::is_scalar() const {
+    return dimids.size() == rank::rank_dim_scalar;
+}
+
+bool var::is_vector() const {
+    return dimids.size() == rank::rank_dim_vector;
+}
+
+bool var::is_matrix() const {
+    //TODO: or greater?
+    return dimids.size() == rank::rank_dim_matrix;
+}
+
+bool is_scalar(var const & theVar) {
+    return theVar.is_scalar();
+}
+
+bool is_vector(var const & theVar) {
+    return theVar.is_vector();
+}
+
+bool is_matrix(var const & theVar) {
+    return theVar.is_matrix();
+}
+
+bool var::is_record(dim_vector const & dims) const {
+
+    // The record dimension length is zero (0).
+    for (auto & dimid : dimids) {
+        if (dims[dimid].is_record())
+            return true;
+    }
+
+    return false;
+}
+
+var var::get_header() const {
+
+    var header(name, type);
+
+    header.dimids = dimids;
+    header.vsize = vsize;
+    header.offset = offset;
+
+    return header;
+}
+
+data_buffer::size_type var::get_nelems(dim_vector const & dims) const {
+
+    data_buffer::size_type result = 1;
+
+    for (auto & dimid : dimids)
+        result *= dims[dimid].get_dim_length_part();
+
+    return result;
+}
+
+bool var::is_loaded() const {
+    return loaded || !loader;
+}
+
+void var::load() {
+
+    if (prefetch.valid()) {
+        take_prefetched();
+        return;
+    }
+
+    if (is_loaded()) return;
+
+    loader->load(*this);
+
+    loaded = true;
+}
+
+void var::unload() {
+
+    // A prefetch still running finishes into a buffer nobody is waiting for any longer.
+    prefetch = std::shared_future<void>();
+    prefetched.reset();
+
+    if (!loader) return;
+
+    data.clear();
+
+    loaded = false;
+}
+
+bool var::is_prefetching() const {
+    return prefetch.valid();
+}
+
+void var::take_prefetched() {
+
+    auto pending = std::move(prefetch);
+    auto theData = std::move(prefetched);
+
+    // Rethrows whatever the load threw, leaving the var to load on its own next time.
+    pending.get();
+
+    data = std::move(*theData);
+    loaded = true;
+}
+
+data_buffer & var::get_data() {
+    load();
+    return data;
+}
+
+data_buffer const & var::get_data() const {
+
+    if (!is_loaded())
+        throw std::logic_error("var not loaded");
+
+    return data;
+}
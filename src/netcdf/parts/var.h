@@ -1,48 +1,104 @@
-#ifndef NETCDF_VAR_H
-#define NETCDF_VAR_H
-
-#pragma once
-
-#include "dim.h"
-#include "valuable.h"
-#include "attributable.h"
-
-///////////////////////////////////////////////////////////////////////////////
-
-typedef union {
-    int32_t begin;
-    int64_t begin64;
-} offset_t;
-
-typedef std::vector<int32_t> dimid_vector;
-
-//TODO: TBD: what other interface this will require to get/set/insert/update/delete variables, in a model-compatible manner
-struct var : public named, public attributable, public valuable {
-    //See rank (dimensionality) ... rank nelems (rank alone? or always INT ...)
-    //TODO: TBD: may consider whether it is feasible to store a pointer or even iterator to iself: what happens when redimming happens, or items added to vector, that invalidates the iterator/pointer? probably...
-    dimid_vector dimids;
-    //TODO: may not support vsize after all? does it make sense to? especially with backward/forward compatibility growth concerns...
-    int32_t vsize;
-    //TODO: TBD: this one could be tricky ...
-    offset_t offset;
-
-    var();
-    var(std::string const & name, nc_type aType);
-    var(var const & other);
-
-    virtual ~var();
-
-    bool is_scalar() const;
-    bool is_vector() const;
-    bool is_matrix() const;
-
-    bool is_record(dim_vector const & dims) const;
-};
-
-bool is_scalar(var const & aVar);
-bool is_vector(var const & aVar);
-bool is_matrix(var const & aVar);
-
-typedef std::vector<var> var_vector;
-
-#endif //NETCDF_VAR_H
+#ifndef NETCDF_VAR_H
+#define NETCDF_VAR_H
+
+#pragma once
+
+#include "dim.h"
+#include "typed.h"
+#include "data_buffer.h"
+#include "data_loader.h"
+#include "attributable.h"
+
+#include <future>
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+
+typedef union {
+    int32_t begin;
+    int64_t begin64;
+} offset_t;
+
+typedef std::vector<int32_t, arena_allocator<int32_t>> dimid_vector;
+
+//TODO: TBD: what other interface this will require to get/set/insert/update/delete variables, in a model-compatible manner
+struct var : public named, public attributable, public typed {
+    //See rank (dimensionality) ... rank nelems (rank alone? or always INT ...)
+    //TODO: TBD: may consider whether it is feasible to store a pointer or even iterator to iself: what happens when redimming happens, or items added to vector, that invalidates the iterator/pointer? probably...
+    dimid_vector dimids;
+    //TODO: may not support vsize after all? does it make sense to? especially with backward/forward compatibility growth concerns...
+    int64_t vsize;
+    //TODO: TBD: this one could be tricky ...
+    offset_t offset;
+    // The variable data itself, natively typed, in a single contiguous block. See get_data.
+    data_buffer data;
+    // Set when the data is loaded on demand, i.e. when the var was read header only.
+    std::shared_ptr<data_loader> loader;
+
+    var();
+    var(std::string const & name, nc_type aType);
+    var(var const & other);
+    var(var && other) noexcept;
+
+    var & operator=(var const & other);
+    var & operator=(var && other) noexcept;
+
+    virtual ~var();
+
+    bool is_scalar() const;
+    bool is_vector() const;
+    bool is_matrix() const;
+
+    bool is_record(dim_vector const & dims) const;
+
+    // A copy of just what says where the data is and what shape: no attrs, no data; as a loader needs.
+    var get_header() const;
+
+    // Number of elements described by the dims, counting the record dimension once.
+    data_buffer::size_type get_nelems(dim_vector const & dims) const;
+
+    template<class _Vector>
+    void set_values(_Vector const & theValues) {
+        data.set_values(theValues);
+        if (!data.empty()) set_type(data.get_type());
+        loaded = true;
+    }
+
+    bool is_loaded() const;
+
+    // Loads the data now, unless it is loaded already.
+    void load();
+
+    // Releases the data, to be loaded again on next access. Vars without a loader keep their data.
+    void unload();
+
+    /* The data, loaded first if need be, or handed over from a prefetch, waiting for it if need be.
+    Data viewed from a mapping stays a view; see data_buffer::materialize. */
+    data_buffer & get_data();
+
+    // The data as it is, never loaded, nor copied; throws when it is not loaded.
+    data_buffer const & get_data() const;
+
+    bool is_prefetching() const;
+
+private:
+
+    bool loaded;
+
+    /* A load running in the background, and the data it is loading into, until the data is next
+    asked for; see netcdf::prefetch_var. Copies of the var do not share it, but load on their own. */
+    std::shared_future<void> prefetch;
+    std::shared_ptr<data_buffer> prefetched;
+
+    void take_prefetched();
+
+    friend struct netcdf;
+};
+
+bool is_scalar(var const & aVar);
+bool is_vector(var const & aVar);
+bool is_matrix(var const & aVar);
+
+typedef std::vector<var, arena_allocator<var>> var_vector;
+
+#endif //NETCDF_VAR_H